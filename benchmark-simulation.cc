@@ -0,0 +1,437 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+//
+// Microbenchmarks of the hot paths of the simulation.
+// Usage:
+//     ./benchmark-simulation \
+//         [--sizes=<num_sensors>[,<num_sensors>...]] \
+//         [--degrees=<degree>[,<degree>...]] \
+//         [--min-time=<seconds>] \
+//         [--filter=<substring>] \
+//         [--seed=<seed>] \
+//         [--json=<file>] \
+//         [--baseline=<file>] \
+//         [--threshold=<percent>]
+//
+// Every benchmark runs on a network of each size and density. The density is
+// given as the degree, i.e. the average number of neighbors of a sensor, from
+// which the communication range is derived, so that networks of all sizes are
+// alike apart from their size. The sensors are placed over the same region as
+// in the simulation.
+//
+// A benchmark repeats its operation until it has run for at least the minimum
+// time, and reports the time per operation, the throughput in sensors per
+// second and the number of heap allocations per operation. The first run of
+// every operation is not measured, so that the buffers reused across
+// operations are already allocated.
+//
+// With --json, the results are also saved in JSON, one benchmark per line.
+// With --baseline, the results are compared with the ones saved by an earlier
+// run: benchmarks that became slower by more than the threshold percentage,
+// 10% by default, or that allocate more often, are reported as regressions,
+// and the exit status is 1.
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "parent-candidates.h"
+#include "random.h"
+#include "region.h"
+#include "routing-builders.h"
+#include "routing-metric-calculators.h"
+#include "routing-tree.h"
+#include "routing-tree-view.h"
+#include "sensor-network.h"
+#include "sensor-placers.h"
+#include "utils.h"
+
+namespace {
+
+std::atomic<int64_t> num_allocations(0);
+
+}  // namespace
+
+// Every allocation of the binary is counted, so that the benchmarks can tell
+// how often an operation allocates.
+void* operator new(size_t size) {
+  num_allocations++;
+  void* p = std::malloc(size > 0 ? size : 1);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+struct BenchmarkOptions {
+  std::vector<int> sizes;
+  std::vector<double> degrees;
+  double min_time;
+  std::string filter;
+  uint64_t seed;
+  std::string json_filename;
+  std::string baseline_filename;
+  double threshold;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  int num_sensors;
+  double degree;
+  int64_t iterations;
+  double ns_per_op;
+  double sensors_per_second;
+  double allocations_per_op;
+};
+
+class BenchmarkRunner {
+ public:
+  explicit BenchmarkRunner(const BenchmarkOptions& options)
+      : options_(options) {}
+
+  // Runs the operation unless the filter excludes the name, and records the
+  // result.
+  void Run(const std::string& name,
+           int num_sensors,
+           double degree,
+           const std::function<void()>& operation) {
+    const std::string full_name = name + "/n=" + IntToString(num_sensors) +
+                                  "/degree=" + FormatDegree(degree);
+    if (full_name.find(options_.filter) == std::string::npos) {
+      return;
+    }
+
+    operation();
+
+    // Run batches of doubling sizes until the minimum time is spent.
+    typedef std::chrono::steady_clock Clock;
+    int64_t iterations = 0;
+    int64_t batch = 1;
+    double elapsed = 0.0;
+    const int64_t allocations = num_allocations;
+    while (elapsed < options_.min_time) {
+      const Clock::time_point start = Clock::now();
+      for (int64_t i = 0; i < batch; i++) {
+        operation();
+      }
+      elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+      iterations += batch;
+      batch *= 2;
+    }
+    const int64_t num_operation_allocations = num_allocations - allocations;
+
+    BenchmarkResult result;
+    result.name = full_name;
+    result.num_sensors = num_sensors;
+    result.degree = degree;
+    result.iterations = iterations;
+    result.ns_per_op = elapsed * 1e9 / iterations;
+    result.sensors_per_second = num_sensors * iterations / elapsed;
+    result.allocations_per_op = double(num_operation_allocations) / iterations;
+    results_.push_back(result);
+    printf("%-56s %10lld %14.0f %14.4g %10.2f\n", result.name.c_str(),
+           (long long) result.iterations, result.ns_per_op,
+           result.sensors_per_second, result.allocations_per_op);
+  }
+
+  const std::vector<BenchmarkResult>& results() const {
+    return results_;
+  }
+
+  static std::string FormatDegree(double degree) {
+    char text[32];
+    snprintf(text, sizeof(text), "%g", degree);
+    return text;
+  }
+
+ private:
+  const BenchmarkOptions& options_;
+  std::vector<BenchmarkResult> results_;
+};
+
+// Runs all benchmarks on a network of the given size and degree.
+void RunNetworkBenchmarks(const BenchmarkOptions& options,
+                          int num_sensors,
+                          double degree,
+                          const std::vector<RoutingBuilder*>& builders,
+                          const std::vector<RoutingMetricCalculator*>&
+                              calculators,
+                          BenchmarkRunner* runner) {
+  Region region;
+  region.min_x = 0.0;
+  region.min_y = 0.0;
+  region.max_x = 100.0;
+  region.max_y = 100.0;
+  const double area =
+      (region.max_x - region.min_x) * (region.max_y - region.min_y);
+  const double range = std::sqrt(degree * area / (M_PI * num_sensors));
+
+  RandomizedSensorPlacer placer(num_sensors, region);
+  Random random = Random::ForCell(options.seed, 0, 0, kPlacementPurpose);
+  std::vector<Position> positions;
+  placer.GeneratePositions(&random, &positions);
+
+  std::vector<Position> placed;
+  runner->Run("place", num_sensors, degree, [&]() {
+    placer.GeneratePositions(&random, &placed);
+  });
+
+  MinimumRangeWorkspace placement;
+  runner->Run("minimum-range", num_sensors, degree, [&]() {
+    CalculateMinimumCommunicationRange(positions, &placement);
+  });
+
+  runner->Run("connectivity", num_sensors, degree, [&]() {
+    CanBeConnected(positions, range, &placement);
+  });
+
+  SensorNetwork network;
+  runner->Run("deploy", num_sensors, degree, [&]() {
+    network.DeploySensors(positions, range);
+  });
+  if (!network.DeploySensors(positions, range)) {
+    printf("%-56s not connected, skipping the routings\n",
+           ("*/n=" + IntToString(num_sensors) + "/degree=" +
+            BenchmarkRunner::FormatDegree(degree)).c_str());
+    return;
+  }
+
+  ParentCandidates candidates;
+  runner->Run("parent-candidates", num_sensors, degree, [&]() {
+    candidates.Build(network);
+  });
+
+  RoutingTree tree;
+  for (int b = 0; b < builders.size(); b++) {
+    Random routing_random =
+        Random::ForCell(options.seed, 0, 0, kRoutingPurpose, b);
+    runner->Run("routing/" + builders[b]->name(), num_sensors, degree, [&]() {
+      builders[b]->BuildRouting(network, &routing_random, &tree);
+    });
+  }
+
+  Random routing_random = Random::ForCell(options.seed, 0, 0, kRoutingPurpose);
+  builders[0]->BuildRouting(network, &routing_random, &tree);
+  RoutingTreeView view;
+  runner->Run("tree-view", num_sensors, degree, [&]() {
+    view.Build(tree);
+  });
+
+  MetricWorkspace workspace;
+  for (int c = 0; c < calculators.size(); c++) {
+    Random metric_random =
+        Random::ForCell(options.seed, 0, 0, kMetricPurpose, c);
+    std::vector<double> values(calculators[c]->num_values());
+    runner->Run("metric/" + calculators[c]->name(), num_sensors, degree,
+                [&]() {
+      calculators[c]->CalculateMetrics(network, view, &metric_random,
+                                       &workspace, values.data());
+    });
+  }
+}
+
+void SaveResults(const std::vector<BenchmarkResult>& results,
+                 const std::string& filename) {
+  FILE* file = std::fopen(filename.c_str(), "w");
+  if (file == NULL) {
+    fprintf(stderr, "Cannot open %s!\n", filename.c_str());
+    exit(1);
+  }
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (int i = 0; i < results.size(); i++) {
+    const BenchmarkResult& result = results[i];
+    fprintf(file,
+            "    {\"name\": \"%s\", \"num_sensors\": %d, \"degree\": %g, "
+            "\"iterations\": %lld, \"ns_per_op\": %.1f, "
+            "\"sensors_per_second\": %.6g, \"allocations_per_op\": %.3f}%s\n",
+            result.name.c_str(), result.num_sensors, result.degree,
+            (long long) result.iterations, result.ns_per_op,
+            result.sensors_per_second, result.allocations_per_op,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  std::fclose(file);
+}
+
+// Reads the results saved by SaveResults(). Only the fields compared with
+// the baseline are read.
+std::map<std::string, BenchmarkResult> LoadResults(
+    const std::string& filename) {
+  FILE* file = std::fopen(filename.c_str(), "r");
+  if (file == NULL) {
+    fprintf(stderr, "Cannot open %s!\n", filename.c_str());
+    exit(1);
+  }
+  std::map<std::string, BenchmarkResult> results;
+  char line[1024];
+  while (std::fgets(line, sizeof(line), file) != NULL) {
+    const char* name = std::strstr(line, "\"name\": \"");
+    const char* ns = std::strstr(line, "\"ns_per_op\": ");
+    const char* allocations = std::strstr(line, "\"allocations_per_op\": ");
+    if (name == NULL || ns == NULL || allocations == NULL) {
+      continue;
+    }
+    name += std::strlen("\"name\": \"");
+    BenchmarkResult result;
+    result.name = std::string(name, std::strchr(name, '"') - name);
+    result.ns_per_op = std::atof(ns + std::strlen("\"ns_per_op\": "));
+    result.allocations_per_op =
+        std::atof(allocations + std::strlen("\"allocations_per_op\": "));
+    results[result.name] = result;
+  }
+  std::fclose(file);
+  return results;
+}
+
+// Prints the change of every benchmark against the baseline. Returns the
+// number of regressions.
+int CompareResults(const std::vector<BenchmarkResult>& results,
+                   const std::map<std::string, BenchmarkResult>& baseline,
+                   double threshold) {
+  printf("\n%-56s %14s %14s %9s\n", "compared with baseline", "baseline ns",
+         "ns/op", "change");
+  int num_regressions = 0;
+  for (int i = 0; i < results.size(); i++) {
+    const BenchmarkResult& result = results[i];
+    std::map<std::string, BenchmarkResult>::const_iterator it =
+        baseline.find(result.name);
+    if (it == baseline.end()) {
+      printf("%-56s %14s %14.0f %9s\n", result.name.c_str(), "-",
+             result.ns_per_op, "new");
+      continue;
+    }
+    const double change = (result.ns_per_op / it->second.ns_per_op - 1.0);
+    const bool slower = change * 100.0 > threshold;
+    // Allocation counts are exact, so any increase is a regression.
+    const bool allocates_more =
+        result.allocations_per_op > it->second.allocations_per_op + 0.5;
+    printf("%-56s %14.0f %14.0f %+8.1f%%%s%s\n", result.name.c_str(),
+           it->second.ns_per_op, result.ns_per_op, change * 100.0,
+           slower ? " SLOWER" : "", allocates_more ? " MORE-ALLOCATIONS" : "");
+    if (slower || allocates_more) {
+      num_regressions++;
+    }
+  }
+  printf("%d regression(s) beyond %g%%\n", num_regressions, threshold);
+  return num_regressions;
+}
+
+// Parses a comma separated list of numbers. Returns false if it is empty or
+// malformed.
+bool ParseNumbers(const std::string& text, std::vector<double>* numbers) {
+  numbers->clear();
+  const char* p = text.c_str();
+  char* end;
+  for (double number = std::strtod(p, &end); end != p;
+       number = std::strtod(p, &end)) {
+    numbers->push_back(number);
+    p = *end == ',' ? end + 1 : end;
+  }
+  return !numbers->empty() && *p == '\0';
+}
+
+int main(int argc, char** argv) {
+  // Disable buffering of stdout.
+  std::setbuf(stdout, NULL);
+
+  BenchmarkOptions options;
+  options.sizes = {100, 1000, 10000, 100000, 1000000};
+  options.degrees = {20.0, 60.0};
+  options.min_time = 0.2;
+  options.seed = 1;
+  options.threshold = 10.0;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    std::string value;
+    std::vector<double> numbers;
+    if (GetOptionValue(arg, "sizes", &value)) {
+      if (!ParseNumbers(value, &numbers)) {
+        fprintf(stderr, "Invalid sizes %s!\n", value.c_str());
+        exit(1);
+      }
+      options.sizes.assign(numbers.begin(), numbers.end());
+    } else if (GetOptionValue(arg, "degrees", &value)) {
+      if (!ParseNumbers(value, &options.degrees)) {
+        fprintf(stderr, "Invalid degrees %s!\n", value.c_str());
+        exit(1);
+      }
+    } else if (GetOptionValue(arg, "min-time", &value)) {
+      options.min_time = std::atof(value.c_str());
+    } else if (GetOptionValue(arg, "filter", &value)) {
+      options.filter = value;
+    } else if (GetOptionValue(arg, "seed", &value)) {
+      options.seed = std::strtoull(value.c_str(), NULL, 10);
+    } else if (GetOptionValue(arg, "json", &value)) {
+      options.json_filename = value;
+    } else if (GetOptionValue(arg, "baseline", &value)) {
+      options.baseline_filename = value;
+    } else if (GetOptionValue(arg, "threshold", &value)) {
+      options.threshold = std::atof(value.c_str());
+    } else {
+      fprintf(stderr, "Unknown option %s!\n", arg.c_str());
+      exit(1);
+    }
+  }
+
+  std::vector<RoutingBuilder*> builders;
+  builders.push_back(new EarliestFirstRoutingBuilder());
+  builders.push_back(new SecondEarliestFirstRoutingBuilder());
+  builders.push_back(new LatestFirstRoutingBuilder());
+  builders.push_back(new NearestFirstRoutingBuilder());
+  builders.push_back(new SecondNearestFirstRoutingBuilder());
+  builders.push_back(new FarthestFirstRoutingBuilder());
+  builders.push_back(new RandomizedRoutingBuilder());
+  builders.push_back(new WeightedRandomizedRoutingBuilder());
+
+  std::vector<RoutingMetricCalculator*> calculators;
+  calculators.push_back(new NodeDegreeVarianceCalculator());
+  calculators.push_back(new RobustnessCalculator(5));
+  calculators.push_back(new RandomFailureRobustnessCalculator(5, 10));
+  calculators.push_back(new ChannelQualityCalculator());
+  calculators.push_back(new DataAggregationCalculator());
+  calculators.push_back(new LatencyCalculator());
+
+  printf("%-56s %10s %14s %14s %10s\n", "benchmark", "iterations", "ns/op",
+         "sensors/s", "allocs/op");
+  BenchmarkRunner runner(options);
+  for (int s = 0; s < options.sizes.size(); s++) {
+    for (int d = 0; d < options.degrees.size(); d++) {
+      RunNetworkBenchmarks(options, options.sizes[s], options.degrees[d],
+                           builders, calculators, &runner);
+    }
+  }
+
+  if (!options.json_filename.empty()) {
+    SaveResults(runner.results(), options.json_filename);
+  }
+  int num_regressions = 0;
+  if (!options.baseline_filename.empty()) {
+    num_regressions = CompareResults(
+        runner.results(), LoadResults(options.baseline_filename),
+        options.threshold);
+  }
+
+  for (int i = 0; i < builders.size(); i++) {
+    delete builders[i];
+  }
+  for (int i = 0; i < calculators.size(); i++) {
+    delete calculators[i];
+  }
+  return num_regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_BIT_MATRIX_H_
+#define NETWORKING_BIT_MATRIX_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+// Square matrix of bits, stored row by row in 64-bit words, e.g. the channels
+// of a small and dense network, where bit j of row i is set if sensors i and j
+// are neighbors. Sets of sensors are then intersected with word-wide ANDs, and
+// counted with popcounts, instead of walking lists of IDs.
+class BitMatrix {
+ public:
+  BitMatrix() : num_rows_(0), words_per_row_(0) {}
+
+  // Resizes the matrix to n x n and clears all bits. The memory only grows,
+  // so it is reused by smaller matrices.
+  void Reset(int n) {
+    num_rows_ = n;
+    words_per_row_ = GetNumWords(n);
+    words_.assign(size_t(num_rows_) * words_per_row_, 0);
+  }
+
+  int num_rows() const {
+    return num_rows_;
+  }
+
+  int words_per_row() const {
+    return words_per_row_;
+  }
+
+  void Set(int row, int column) {
+    words_[size_t(row) * words_per_row_ + column / 64] |=
+        uint64_t(1) << (column % 64);
+  }
+
+  const uint64_t* GetRow(int row) const {
+    return words_.data() + size_t(row) * words_per_row_;
+  }
+
+  // Returns the number of words of a row of n bits.
+  static int GetNumWords(int n) {
+    return (n + 63) / 64;
+  }
+
+ private:
+  int num_rows_;
+  int words_per_row_;
+  std::vector<uint64_t> words_;
+};
+
+inline int CountBits(uint64_t word) {
+  return __builtin_popcountll(word);
+}
+
+// Returns the index of the lowest set bit of a non-zero word.
+inline int GetLowestBit(uint64_t word) {
+  return __builtin_ctzll(word);
+}
+
+#endif  // NETWORKING_BIT_MATRIX_H_
@@ -3,7 +3,23 @@
 // Created By: Min Xu <xukmin@gmail.com>
 //
 // Build example routing networks.
+// Usage:
+//     ./build-routings \
+//         [<num_sensors>] \
+//         [<communication_range>] \
+//         [--seed=<seed>] \
+//         [--channel-stride=<n>] \
+//         [--min-node-radius=<pixels>] \
+//         [--trace=<file>]
+//
+// For large networks, --channel-stride only prints every n-th channel, and
+// sensors are hidden once they are shrunk below --min-node-radius pixels to
+// fit the image. With --trace, the time of every phase is saved to the given
+// file in the Chrome trace-event format, and summarized at exit.
+
+#include <stdint.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -11,26 +27,52 @@
 #include <iostream>
 #include <string>
 
+#include "random.h"
 #include "region.h"
 #include "routing-builders.h"
-#include "routing-metric-calculators.h"
+#include "routing-tree.h"
 #include "sensor-network.h"
 #include "sensor-placers.h"
 #include "svg-printer.h"
+#include "trace.h"
 #include "utils.h"
 
 int main(int argc, char** argv) {
-  std::srand(std::time(NULL));
-
   int num_sensors = 100;
   double communication_range = 20.0;
   double scale = 6.0;
+  uint64_t seed = std::time(NULL);
+  SvgDetail detail;
+  std::string trace_filename;
+
+  std::vector<const char*> args;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    std::string value;
+    if (GetOptionValue(arg, "seed", &value)) {
+      seed = std::strtoull(value.c_str(), NULL, 10);
+    } else if (GetOptionValue(arg, "channel-stride", &value)) {
+      detail.channel_stride = std::max(1, std::atoi(value.c_str()));
+    } else if (GetOptionValue(arg, "min-node-radius", &value)) {
+      detail.min_node_radius = std::atof(value.c_str());
+    } else if (GetOptionValue(arg, "trace", &value)) {
+      trace_filename = value;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
 
-  if (argc > 1) {
-    num_sensors = std::atoi(argv[1]);
+  if (args.size() > 0) {
+    num_sensors = std::atoi(args[0]);
   }
-  if (argc > 2) {
-    communication_range = std::atof(argv[2]);
+  if (args.size() > 1) {
+    communication_range = std::atof(args[1]);
+  }
+  printf("seed = %llu\n", (unsigned long long) seed);
+
+  if (!trace_filename.empty() && !StartTracing(trace_filename)) {
+    fprintf(stderr, "Cannot open %s!\n", trace_filename.c_str());
+    exit(1);
   }
 
   Region region;
@@ -51,20 +93,25 @@ int main(int argc, char** argv) {
 
   RandomizedSensorPlacer placer(num_sensors, region);
   std::vector<Position> positions;
-  GeneratePositionsThatCanBeConnected(communication_range, &placer, &positions);
-
+  Random placement_random = Random::ForCell(seed, 0, 0, kPlacementPurpose);
   SensorNetwork network;
-  network.DeploySensors(positions, communication_range);
+  DeploySensorsThatAreConnected(communication_range, placer,
+                                &placement_random, &positions, &network);
 
+  RoutingTree tree;
   for (int i = 0; i < builders.size(); i++) {
-    builders[i]->BuildRouting(&network);
+    Random routing_random = Random::ForCell(seed, 0, 0, kRoutingPurpose, i);
+    builders[i]->BuildRouting(network, &routing_random, &tree);
 
     const std::string filename = "routings-" + IntToString(num_sensors) + "-" +
                                  builders[i]->name() + ".svg";
-    SvgPrinter printer(filename, builders[i]->title(), region, scale);
-    printer.PrintNetwork(network);
+    ScopedTimer timer("svg", builders[i]->name().c_str());
+    SvgPrinter printer(filename, builders[i]->title(), region, scale, detail);
+    printer.PrintNetwork(network, tree);
   }
 
+  FinishTracing();
+
   for (int i = 0; i < builders.size(); i++) {
     delete builders[i];
   }
@@ -9,42 +9,166 @@
 //         [<repetitions>] \
 //         [<lower_communication_range>] \
 //         [<upper_communication_range>] \
-//         [<communcation_range_step>]
+//         [<communcation_range_step>] \
+//         [--threads=<num_threads>] \
+//         [--seed=<seed>] \
+//         [--max-failures=<k>] \
+//         [--failure-orderings=<num_orderings>] \
+//         [--cell=<range_index>:<repetition>] \
+//         [--common-placement] \
+//         [--placement=regenerate|repair] \
+//         [--raw-samples=<file>] \
+//         [--event-grid=<cols>x<rows>] \
+//         [--random-events=<num_events>] \
+//         [--sensing-ranges=<range>[,<range>...]] \
+//         [--trace=<file>] \
+//         [--large-scale] \
+//         [--memory-budget=<megabytes>]
 //
 // All arguments are optional. Simply run without any arguments to perform
-// simulation with default configurations.
+// simulation with default configurations. The simulations run on as many
+// threads as the hardware supports by default.
+//
+// Runs with the same seed produce the same results. With --cell, only the
+// given simulation cell of the run is recreated: its routing networks are
+// saved as SVG images and its metrics printed, which helps debugging a
+// single data point of a large sweep.
+//
+// With --common-placement, every repetition places the sensors once and
+// sweeps all communication ranges on that placement, adding the channels of
+// every range to the ones of the previous range. The placement of a
+// repetition must be connected at the lowest range of the sweep, whereas a
+// cell of its own only needs to be connected at its range, so the two modes
+// sample the placements of the higher ranges differently.
+//
+// Placements which are not connected at the communication range of their
+// cell are thrown away and placed again. With --placement=repair, only the
+// sensors not connected to the base station are placed again instead, see
+// PlacementMode.
+//
+// Besides the means, the statistics of every metric, i.e. its standard
+// deviation, minimum, percentiles and maximum, are saved per communication
+// range. With --raw-samples, every single metric value is also appended to the
+// given binary file, see RawSample, so that the results can be analysed again
+// without rerunning the simulation.
+//
+// With --event-grid or --random-events, the event-driven metrics are evaluated
+// for a whole field of events in every simulated network, instead of the
+// single default event, and summarized per routing algorithm.
+//
+// With --trace, the time of every phase of every simulation, e.g. the sensor
+// placement, the channels, the parent candidates, every routing algorithm and
+// every metric, and counters such as the placement retries are saved to the
+// given file in the Chrome trace-event format, and summarized at exit.
+//
+// With --large-scale, networks of millions of sensors are simulated within a
+// memory budget: the example routing networks are not saved as images, and
+// fewer threads are used if the simulations of all threads would not fit into
+// the budget, see EstimateBytesPerSensor().
+
+#include <stdint.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <string>
 
+#include "events.h"
+#include "parallel-executor.h"
+#include "random.h"
 #include "region.h"
 #include "routing-metric-calculators.h"
 #include "routing-builders.h"
+#include "routing-tree.h"
+#include "routing-tree-view.h"
+#include "sample-log.h"
 #include "sensor-network.h"
 #include "sensor-placers.h"
+#include "statistics.h"
 #include "svg-printer.h"
+#include "trace.h"
 #include "utils.h"
 
 struct SimulationOptions {
   int num_sensors;
   int times;
+  int num_threads;
+  uint64_t seed;
   Region region;
   double lower_communication_range;
   double upper_communication_range;
   double communication_range_step;
+  int max_failures;
+  int num_failure_orderings;
+  bool common_placement;
+  PlacementMode placement_mode;
+  std::string raw_samples_filename;
+  std::string trace_filename;
+  bool large_scale;
+  // Memory available to the simulations of all threads in large-scale mode,
+  // in bytes.
+  int64_t memory_budget;
   std::vector<RoutingBuilder*> builders;
   std::vector<RoutingMetricCalculator*> calculators;
+
+  // Event field of the event field sweep. The events are either at the
+  // centers of the event grid, or num_random_events random positions per
+  // simulation cell, binned into the event grid for the heatmaps. Every
+  // position has one event per sensing range.
+  int event_grid_cols;
+  int event_grid_rows;
+  int num_random_events;
+  std::vector<double> sensing_ranges;
+  std::vector<EventMetricCalculator*> event_calculators;
 };
 
+bool IsEventFieldSweep(const SimulationOptions& options) {
+  return !options.event_calculators.empty();
+}
+
+// Returns the estimated memory of a worker thread per sensor in bytes, for
+// the average number of neighbors at the upper communication range, ignoring
+// the borders of the region. Besides the positions and the few parent
+// candidates, routings and metric buffers per sensor, every channel takes 4
+// bytes at each end. A common placement also keeps the pairs of sensors
+// within the upper range, and the routings of all builders. The constants are
+// measured with a million sensors; see the README for the breakdown.
+double EstimateBytesPerSensor(const SimulationOptions& options) {
+  const double kBytesPerSensor = 200.0;
+  const double kBytesPerNeighbor = 7.0;
+  // The vector of the pairs grows by doubling, which leaves some room.
+  const double kBytesPerPair = 1.5 * sizeof(SensorPair);
+  const double kBytesPerRouting = 20.0;
+
+  const Region& region = options.region;
+  const double area =
+      (region.max_x - region.min_x) * (region.max_y - region.min_y);
+  const double range = options.upper_communication_range;
+  const double degree =
+      std::min(M_PI * range * range / area, 1.0) * (options.num_sensors - 1);
+  double bytes = kBytesPerSensor + kBytesPerNeighbor * degree;
+  if (options.common_placement) {
+    bytes += kBytesPerPair * degree / 2 +
+             kBytesPerRouting * options.builders.size();
+  }
+  return bytes;
+}
+
 void PrintSimulationOptions(const SimulationOptions& options) {
   printf("SimulationOptions:\n");
   printf("num_sensors = %d\n", options.num_sensors);
   printf("times = %d\n", options.times);
+  printf("num_threads = %d\n", options.num_threads);
+  printf("seed = %llu\n", (unsigned long long) options.seed);
+  printf("scalar = %s\n", sizeof(Scalar) == sizeof(float) ? "float" : "double");
   printf("region.min_x = %f\n", options.region.min_x);
   printf("region.min_y = %f\n", options.region.min_y);
   printf("region.max_x = %f\n", options.region.max_x);
@@ -52,6 +176,35 @@ void PrintSimulationOptions(const SimulationOptions& options) {
   printf("lower_communication_range = %f\n", options.lower_communication_range);
   printf("upper_communication_range = %f\n", options.upper_communication_range);
   printf("communication_range_step = %f\n", options.communication_range_step);
+  printf("max_failures = %d\n", options.max_failures);
+  printf("num_failure_orderings = %d\n", options.num_failure_orderings);
+  printf("common_placement = %s\n",
+         options.common_placement ? "true" : "false");
+  printf("placement = %s\n",
+         options.placement_mode == kRepairPlacement ? "repair" : "regenerate");
+  if (!options.raw_samples_filename.empty()) {
+    printf("raw_samples = %s\n", options.raw_samples_filename.c_str());
+  }
+  if (!options.trace_filename.empty()) {
+    printf("trace = %s\n", options.trace_filename.c_str());
+  }
+  if (options.large_scale) {
+    printf("large_scale = true\n");
+    printf("memory_budget = %lld MB\n",
+           (long long) (options.memory_budget >> 20));
+    printf("estimated_bytes_per_sensor = %.0f\n",
+           EstimateBytesPerSensor(options));
+  }
+  if (IsEventFieldSweep(options)) {
+    printf("event_grid = %dx%d\n", options.event_grid_cols,
+           options.event_grid_rows);
+    printf("num_random_events = %d\n", options.num_random_events);
+    printf("sensing_ranges =");
+    for (int i = 0; i < options.sensing_ranges.size(); i++) {
+      printf(" %f", options.sensing_ranges[i]);
+    }
+    printf("\n");
+  }
   printf("\n");
   printf("Routing Building Algorithms:\n");
   for (int i = 0; i < options.builders.size(); i++) {
@@ -62,129 +215,826 @@ void PrintSimulationOptions(const SimulationOptions& options) {
   for (int i = 0; i < options.calculators.size(); i++) {
     printf("%s\n", options.calculators[i]->name().c_str());
   }
+  for (int i = 0; i < options.event_calculators.size(); i++) {
+    printf("%s (event field)\n", options.event_calculators[i]->name().c_str());
+  }
 }
 
-void BuildExampleRoutingNetworks(const SimulationOptions& options) {
-  double scale = 600.0 / (options.region.max_y - options.region.min_y);
+// Returns the communication ranges to simulate, in ascending order.
+std::vector<double> GetCommunicationRanges(const SimulationOptions& options) {
+  std::vector<double> ranges;
+  for (double range = options.lower_communication_range;
+       range < options.upper_communication_range;
+       range += options.communication_range_step) {
+    ranges.push_back(range);
+  }
+  return ranges;
+}
 
-  RandomizedSensorPlacer placer(options.num_sensors, options.region);
-  std::vector<Position> positions;
-  GeneratePositionsThatCanBeConnected(
-      options.lower_communication_range, &placer, &positions);
+// A routing tree and its view, which the metrics are calculated from.
+struct CellRouting {
+  RoutingTree tree;
+  RoutingTreeView view;
+};
 
+// Memory of one worker thread, reused by all the simulation cells it runs.
+// Once the buffers have grown to the size of the networks, a worker allocates
+// no memory per cell.
+struct Workspace {
+  std::vector<Position> positions;
+  MinimumRangeWorkspace placement;
   SensorNetwork network;
-  network.DeploySensors(positions, options.lower_communication_range);
+  CellRouting routing;
 
-  for (int i = 0; i < options.builders.size(); i++) {
-    options.builders[i]->BuildRouting(&network);
+  // routing of every builder, kept across the ranges of a common placement.
+  std::vector<CellRouting> sweep_routings;
+
+  MetricWorkspace metrics;
+  std::vector<Event> events;
+  EventBatch batch;
+  std::vector<RawSample> samples;
+};
+
+// Deploys the sensors of the simulation cell with the given communication
+// range and repetition into the network of the workspace. Every cell draws
+// from its own random number streams, so any cell can be recreated without
+// simulating the others.
+void DeployCell(const SimulationOptions& options,
+                double range,
+                int range_index,
+                int repetition,
+                Workspace* workspace) {
+  Random random = Random::ForCell(options.seed, range_index, repetition,
+                                  kPlacementPurpose);
+  RandomizedSensorPlacer placer(options.num_sensors, options.region);
+  DeploySensorsThatAreConnected(range, placer, &random, &workspace->positions,
+                                &workspace->network, &workspace->placement,
+                                options.placement_mode);
+}
+
+// Deploys the sensors of the given repetition for a sweep over all the
+// ranges, with the channels of the lowest range. The placement is connected at
+// the lowest range, and hence at every range.
+void DeployRepetition(const SimulationOptions& options,
+                      const std::vector<double>& ranges,
+                      int repetition,
+                      Workspace* workspace) {
+  Random random = Random::ForCell(options.seed, 0, repetition,
+                                  kPlacementPurpose);
+  RandomizedSensorPlacer placer(options.num_sensors, options.region);
+  GeneratePositionsThatCanBeConnected(ranges.front(), placer, &random,
+                                      &workspace->positions,
+                                      &workspace->placement,
+                                      options.placement_mode);
+  workspace->network.DeploySensors(workspace->positions, ranges.front(),
+                                   ranges.back());
+}
+
+// Stores the index of the first value of every calculator into offsets, so
+// that the values of calculator c of a routing are at offsets[c] ..
+// offsets[c] + num_values() - 1. Returns the number of values of all
+// calculators.
+int GetValueOffsets(const SimulationOptions& options,
+                    std::vector<int>* offsets) {
+  offsets->resize(options.calculators.size());
+  int num_values = 0;
+  for (int c = 0; c < options.calculators.size(); c++) {
+    (*offsets)[c] = num_values;
+    num_values += options.calculators[c]->num_values();
+  }
+  return num_values;
+}
+
+void BuildCellRouting(const SimulationOptions& options,
+                      int range_index,
+                      int repetition,
+                      int builder,
+                      const SensorNetwork& network,
+                      CellRouting* routing) {
+  Random random = Random::ForCell(options.seed, range_index, repetition,
+                                  kRoutingPurpose, builder);
+  options.builders[builder]->BuildRouting(network, &random, &routing->tree);
+  routing->view.Build(routing->tree);
+}
+
+typedef std::function<void(int range_index,
+                           int builder,
+                           const SensorNetwork& network,
+                           const CellRouting& routing)> RoutingVisitor;
+
+// Simulates the cells of the given repetition for the range indices 0 ..
+// last_range_index on the common placement of the repetition, and calls visit
+// for every routing of every range, in ascending order of ranges. The routings
+// of the builders determined by the parent candidates are only rebuilt when
+// the channels added for a range may change the candidates; otherwise their
+// trees of the previous range are visited again. The randomized routings are
+// rebuilt for every range, from the generator of its cell.
+void SweepCommonPlacement(const SimulationOptions& options,
+                          const std::vector<double>& ranges,
+                          int repetition,
+                          int last_range_index,
+                          Workspace* workspace,
+                          const RoutingVisitor& visit) {
+  DeployRepetition(options, ranges, repetition, workspace);
+  SensorNetwork& network = workspace->network;
+  std::vector<CellRouting>& routings = workspace->sweep_routings;
+  routings.resize(options.builders.size());
+  for (int r = 0; r <= last_range_index; r++) {
+    bool changed = r == 0 || network.ExtendCommunicationRange(ranges[r]);
+    for (int b = 0; b < options.builders.size(); b++) {
+      if (changed || !options.builders[b]->IsDeterminedByCandidates()) {
+        BuildCellRouting(options, r, repetition, b, network, &routings[b]);
+      }
+      visit(r, b, network, routings[b]);
+    }
+  }
+}
+
+// Stores the values of all calculators for the routing of the given builder
+// into values, at the offsets from GetValueOffsets().
+void CalculateCellMetrics(const SimulationOptions& options,
+                          int range_index,
+                          int repetition,
+                          int builder,
+                          const SensorNetwork& network,
+                          const RoutingTreeView& tree,
+                          const std::vector<int>& offsets,
+                          MetricWorkspace* workspace,
+                          double* values) {
+  for (int c = 0; c < options.calculators.size(); c++) {
+    Random random = Random::ForCell(
+        options.seed, range_index, repetition, kMetricPurpose,
+        builder * options.calculators.size() + c);
+    ScopedTimer timer("metric", options.calculators[c]->name().c_str());
+    options.calculators[c]->CalculateMetrics(network, tree, &random, workspace,
+                                             values + offsets[c]);
+  }
+}
 
+// Saves the routing networks of the given simulation cell as SVG images
+// named <prefix><builder>.svg. Prints the metrics of every routing network if
+// print_metrics is true.
+void SaveCellRoutingNetworks(const SimulationOptions& options,
+                             int range_index,
+                             int repetition,
+                             const std::string& prefix,
+                             bool print_metrics) {
+  const std::vector<double> ranges = GetCommunicationRanges(options);
+  if (range_index < 0 || range_index >= ranges.size() ||
+      repetition < 0 || repetition >= options.times) {
+    fprintf(stderr, "Cell %d:%d is out of the simulated ranges!\n",
+            range_index, repetition);
+    exit(1);
+  }
+  double scale = 600.0 / (options.region.max_y - options.region.min_y);
+
+  std::vector<int> offsets;
+  std::vector<double> values(GetValueOffsets(options, &offsets));
+  Workspace workspace;
+
+  auto save = [&](int builder, const SensorNetwork& network,
+                  const CellRouting& routing) {
     const std::string filename =
-        "routings-" + IntToString(options.num_sensors) + "-" +
-        options.builders[i]->name() + ".svg";
-    SvgPrinter printer(filename, options.builders[i]->title(),
+        prefix + options.builders[builder]->name() + ".svg";
+    SvgPrinter printer(filename, options.builders[builder]->title(),
                        options.region, scale);
-    printer.PrintNetwork(network);
+    printer.PrintNetwork(network, routing.tree);
+
+    if (print_metrics) {
+      printf("\n%s (%s):\n", options.builders[builder]->name().c_str(),
+             filename.c_str());
+      CalculateCellMetrics(options, range_index, repetition, builder,
+                           network, routing.view, offsets, &workspace.metrics,
+                           values.data());
+      for (int c = 0; c < options.calculators.size(); c++) {
+        printf("%s =", options.calculators[c]->name().c_str());
+        for (int v = 0; v < options.calculators[c]->num_values(); v++) {
+          printf(" %f", values[offsets[c] + v]);
+        }
+        printf("\n");
+      }
+    }
+  };
+
+  if (options.common_placement) {
+    SweepCommonPlacement(
+        options, ranges, repetition, range_index, &workspace,
+        [&](int r, int builder, const SensorNetwork& network,
+            const CellRouting& routing) {
+          if (r == range_index) {
+            save(builder, network, routing);
+          }
+        });
+  } else {
+    DeployCell(options, ranges[range_index], range_index, repetition,
+               &workspace);
+    for (int i = 0; i < options.builders.size(); i++) {
+      BuildCellRouting(options, range_index, repetition, i, workspace.network,
+                       &workspace.routing);
+      save(i, workspace.network, workspace.routing);
+    }
+  }
+}
+
+// The example routing networks are the ones of the first simulation cell.
+// They are not saved in large-scale mode, where the images would take
+// gigabytes.
+void BuildExampleRoutingNetworks(const SimulationOptions& options) {
+  if (options.large_scale) {
+    return;
   }
+  SaveCellRoutingNetworks(options, 0, 0,
+                          "routings-" + IntToString(options.num_sensors) + "-",
+                          false);
 }
 
+// Statistics of the values of a metric. Only positive values go into the
+// statistics, the others mean the metric does not apply, and are merely
+// counted.
+struct MetricSummary {
+  MetricSummary() : num_skipped(0) {}
+
+  void Add(double value) {
+    if (value > 0.0) {
+      statistics.Add(value);
+    } else {
+      num_skipped++;
+    }
+  }
+
+  MetricStatistics statistics;
+  int64_t num_skipped;
+};
+
+// Writes the mean, standard deviation, minimum, 5th, 50th and 95th
+// percentiles, maximum, number of positive values and number of other values
+// of the summary, every one after a space.
+void WriteMetricSummary(const MetricSummary& summary, std::ostream* os) {
+  const MetricStatistics& statistics = summary.statistics;
+  *os << " " << statistics.mean() << " " << statistics.stddev() << " "
+      << statistics.min() << " " << statistics.Quantile(0.05) << " "
+      << statistics.Quantile(0.50) << " " << statistics.Quantile(0.95) << " "
+      << statistics.max() << " " << statistics.count() << " "
+      << summary.num_skipped;
+}
+
+// Statistics of the metric values of all repetitions, per communication
+// range, builder and metric value.
+//
+// The values of a communication range are only kept until all of its
+// repetitions are done. The thread which finishes the last repetition then
+// adds them to the statistics in the order of the repetitions, so that the
+// results do not depend on the number of threads, while only the ranges in
+// progress are held in memory.
 class RoutingMetrics {
  public:
-  explicit RoutingMetrics(const SimulationOptions& options) : options_(options) {
+  RoutingMetrics(const SimulationOptions& options, int num_ranges)
+      : options_(options),
+        pending_(num_ranges),
+        data_(num_ranges) {
+    num_values_ = GetValueOffsets(options_, &offsets_);
+    for (int r = 0; r < num_ranges; r++) {
+      data_[r].resize(options_.builders.size());
+      for (int i = 0; i < options_.builders.size(); i++) {
+        data_[r][i].resize(num_values_);
+      }
+    }
   }
 
-  void AddRange(double range) {
-    data_[range].resize(options_.builders.size());
-    for (int i = 0; i < options_.builders.size(); i++) {
-      data_[range][i].resize(options_.calculators.size());
+  // Returns the array to store the metric values of the given simulation cell
+  // into, at index builder * num_values + offset, with the offsets from
+  // GetValueOffsets().
+  double* StartCell(int range_index, int repetition) {
+    const int num_metrics = options_.builders.size() * num_values_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    PendingRange& range = pending_[range_index];
+    if (range.values.empty()) {
+      range.remaining = options_.times;
+      range.values.resize(options_.times * num_metrics);
     }
+    return &range.values[repetition * num_metrics];
   }
 
-  void AddData(double range, int builder, int calculator, double metric) {
-    assert(data_.find(range) != data_.end());
-    std::pair<double, int>& p = data_[range][builder][calculator];
-    p.first += metric;
-    p.second++;
+  void FinishCell(int range_index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_[range_index].remaining > 0) {
+        return;
+      }
+    }
+    Summarize(range_index);
   }
 
-  double GetData(double range, int builder, int calculator) const {
-    const std::pair<double, int>& p = data_[range][builder][calculator];
-    if (p.second > 0) {
-      return p.first / p.second;
-    } else {
-      return 0.0;
-    }
+  // Returns the mean of the positive metric values.
+  double GetData(int range_index, int builder, int calculator,
+                 int value) const {
+    return GetSummary(range_index, builder, calculator, value)
+        .statistics.mean();
+  }
+
+  const MetricSummary& GetSummary(int range_index, int builder,
+                                  int calculator, int value) const {
+    return data_[range_index][builder][offsets_[calculator] + value];
   }
 
  private:
+  struct PendingRange {
+    PendingRange() : remaining(0) {}
+
+    int remaining;
+    std::vector<double> values;
+  };
+
+  void Summarize(int range_index) {
+    PendingRange& range = pending_[range_index];
+    std::vector<std::vector<MetricSummary> >& summaries = data_[range_index];
+    const double* values = range.values.data();
+    for (int rep = 0; rep < options_.times; rep++) {
+      for (int b = 0; b < summaries.size(); b++) {
+        for (int i = 0; i < num_values_; i++) {
+          summaries[b][i].Add(*values++);
+        }
+      }
+    }
+
+    // Release the values of the range. No other thread touches the range
+    // once all of its repetitions are done.
+    std::vector<double>().swap(range.values);
+  }
+
   const SimulationOptions options_;
 
-  // range -> builder index -> metric index ->
-  //   (sum of metric values, num of metric values)
-  mutable std::map<double, std::vector<std::vector<std::pair<double, int> > > >
-      data_;
+  // Index of the first value of every calculator.
+  std::vector<int> offsets_;
+
+  int num_values_;
+
+  std::mutex mutex_;
+  std::vector<PendingRange> pending_;
+
+  // range index -> builder index -> metric value index -> statistics
+  std::vector<std::vector<std::vector<MetricSummary> > > data_;
 };
 
-void CalculateMetrics(const SimulationOptions& options, RoutingMetrics* metrics) {
-  RandomizedSensorPlacer placer(options.num_sensors, options.region);
+// Prints the communication ranges in ascending order as soon as all
+// repetitions of them are done, no matter in which order the worker threads
+// finish them.
+class ProgressPrinter {
+ public:
+  ProgressPrinter(const std::vector<double>& ranges, int times)
+      : ranges_(ranges), remaining_(ranges.size(), times), next_(0) {
+  }
 
-  for (double range = options.lower_communication_range;
-       range < options.upper_communication_range;
-       range += options.communication_range_step) {
-    if (int(range * 10) % 10 == 0) {
-      printf("\nrange = %.1f", range);
-    } else {
-      printf(" %.1f", range);
+  void FinishRepetition(int range_index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    remaining_[range_index]--;
+    while (next_ < ranges_.size() && remaining_[next_] == 0) {
+      double range = ranges_[next_++];
+      if (int(range * 10) % 10 == 0) {
+        printf("\nrange = %.1f", range);
+      } else {
+        printf(" %.1f", range);
+      }
     }
+  }
 
-    metrics->AddRange(range);
-    for (int i = 0; i < options.times; i++) {
-      std::vector<Position> positions;
-      GeneratePositionsThatCanBeConnected(range, &placer, &positions);
-
-      SensorNetwork network;
-      network.DeploySensors(positions, range);
+ private:
+  const std::vector<double>& ranges_;
+  std::mutex mutex_;
+  std::vector<int> remaining_;
+  int next_;
+};
 
-      for (int b = 0; b < options.builders.size(); b++) {
-        options.builders[b]->BuildRouting(&network);
-        for (int c = 0; c < options.calculators.size(); c++) {
-          double metric = options.calculators[c]->CalculateMetric(network);
-          if (metric > 0.0) {
-            metrics->AddData(range, b, c, metric);
-          }
-        }
+// Appends the metric values of all routings of the given simulation cell to
+// the log, if any. The samples are collected in the given buffer first.
+void LogCellSamples(const SimulationOptions& options,
+                    double range,
+                    int range_index,
+                    int repetition,
+                    const double* cell_values,
+                    std::vector<RawSample>* samples,
+                    RawSampleLog* log) {
+  if (log == NULL) {
+    return;
+  }
+  samples->clear();
+  for (int b = 0; b < options.builders.size(); b++) {
+    for (int c = 0; c < options.calculators.size(); c++) {
+      for (int v = 0; v < options.calculators[c]->num_values(); v++) {
+        RawSample sample;
+        sample.seed = options.seed;
+        sample.communication_range = range;
+        sample.metric = *cell_values++;
+        sample.num_sensors = options.num_sensors;
+        sample.range_index = range_index;
+        sample.repetition = repetition;
+        sample.builder = b;
+        sample.calculator = c;
+        sample.value = v;
+        samples->push_back(sample);
       }
     }
   }
+  log->Append(samples->data(), samples->size());
+}
+
+// Every (communication range, repetition) pair is an independent simulation
+// cell with its own random number streams. Cells run in parallel, each worker
+// thread reusing its own Workspace. The builders and calculators are shared,
+// as they do not keep any state. The metric values of
+// every finished cell are appended to log, unless it is NULL.
+void CalculateMetrics(const SimulationOptions& options,
+                      RawSampleLog* log,
+                      RoutingMetrics* metrics) {
+  const std::vector<double> ranges = GetCommunicationRanges(options);
+  const int num_builders = options.builders.size();
+  std::vector<int> offsets;
+  const int num_values = GetValueOffsets(options, &offsets);
+  const int num_cells = ranges.size() * options.times;
+
+  ParallelExecutor executor(options.num_threads);
+  std::vector<Workspace> workspaces(executor.num_workers());
+  ProgressPrinter progress(ranges, options.times);
+
+  if (options.common_placement) {
+    // Every repetition is a task which runs the cells of all ranges.
+    executor.Run(options.times, [&](int worker, int repetition) {
+      ScopedTimer timer("simulation", "repetition");
+      Workspace& workspace = workspaces[worker];
+      double* cell_values = NULL;
+      SweepCommonPlacement(
+          options, ranges, repetition, ranges.size() - 1, &workspace,
+          [&](int r, int b, const SensorNetwork& network,
+              const CellRouting& routing) {
+            if (b == 0) {
+              cell_values = metrics->StartCell(r, repetition);
+            }
+            CalculateCellMetrics(options, r, repetition, b, network,
+                                 routing.view, offsets, &workspace.metrics,
+                                 cell_values + b * num_values);
+            if (b == num_builders - 1) {
+              LogCellSamples(options, ranges[r], r, repetition, cell_values,
+                             &workspace.samples, log);
+              metrics->FinishCell(r);
+              progress.FinishRepetition(r);
+            }
+          });
+    });
+  } else {
+    executor.Run(num_cells, [&](int worker, int cell) {
+      ScopedTimer timer("simulation", "cell");
+      const int range_index = cell / options.times;
+      const int repetition = cell % options.times;
+      Workspace& workspace = workspaces[worker];
+      DeployCell(options, ranges[range_index], range_index, repetition,
+                 &workspace);
+
+      double* cell_values = metrics->StartCell(range_index, repetition);
+      for (int b = 0; b < num_builders; b++) {
+        BuildCellRouting(options, range_index, repetition, b,
+                         workspace.network, &workspace.routing);
+        CalculateCellMetrics(options, range_index, repetition, b,
+                             workspace.network, workspace.routing.view,
+                             offsets, &workspace.metrics,
+                             cell_values + b * num_values);
+      }
+      LogCellSamples(options, ranges[range_index], range_index, repetition,
+                     cell_values, &workspace.samples, log);
+      metrics->FinishCell(range_index);
+      progress.FinishRepetition(range_index);
+    });
+  }
   printf("\n");
 }
 
+// Every line of a data file holds a communication range followed by the
+// metric values of every builder. Metrics with multiple values per routing
+// have one such group of builder columns per value.
+//
+// Every line of a statistics file holds a communication range followed by
+// the mean, standard deviation, minimum, 5th, 50th and 95th percentiles,
+// maximum, number of positive values and number of other values, for every
+// builder, in the same order of columns as the data file.
 void SaveMetrics(const SimulationOptions& options,
                  const RoutingMetrics& metrics) {
+  const std::vector<double> ranges = GetCommunicationRanges(options);
   for (int c = 0; c < options.calculators.size(); c++) {
     const std::string filename =
         "metrics-" + IntToString(options.num_sensors) + "-" +
         options.calculators[c]->name() + ".dat";
+    const std::string stats_filename =
+        "metrics-" + IntToString(options.num_sensors) + "-" +
+        options.calculators[c]->name() + "-stats.dat";
 
-    printf("Writing %s metrics to %s ...\n",
-           options.calculators[c]->name().c_str(), filename.c_str());
+    printf("Writing %s metrics to %s and %s ...\n",
+           options.calculators[c]->name().c_str(), filename.c_str(),
+           stats_filename.c_str());
 
     std::ofstream fs(filename.c_str());
+    std::ofstream ss(stats_filename.c_str());
 
-    for (double range = options.lower_communication_range;
-         range < options.upper_communication_range;
-         range += options.communication_range_step) {
+    for (int r = 0; r < ranges.size(); r++) {
+      const double range = ranges[r];
       fs << range;
-      for (int b = 0; b < options.builders.size(); b++) {
-        fs << " " << metrics.GetData(range, b, c);
+      ss << range;
+      for (int v = 0; v < options.calculators[c]->num_values(); v++) {
+        for (int b = 0; b < options.builders.size(); b++) {
+          fs << " " << metrics.GetData(r, b, c, v);
+          WriteMetricSummary(metrics.GetSummary(r, b, c, v), &ss);
+        }
       }
       fs << std::endl;
+      ss << std::endl;
     }
   }
 }
 
-int main(int argc, char** argv) {
-  std::srand(std::time(NULL));
+// Returns the number of event positions per simulation cell.
+int GetNumEventPositions(const SimulationOptions& options) {
+  if (options.num_random_events > 0) {
+    return options.num_random_events;
+  }
+  return options.event_grid_cols * options.event_grid_rows;
+}
+
+// Replaces events with the event field of the given simulation cell. Random
+// events draw from their own stream of the cell, so they do not disturb the
+// streams of the sensor placement and the routings.
+void GenerateCellEvents(const SimulationOptions& options,
+                        int range_index,
+                        int repetition,
+                        std::vector<Event>* events) {
+  if (options.num_random_events > 0) {
+    Random random = Random::ForCell(options.seed, range_index, repetition,
+                                    kEventPurpose);
+    GenerateRandomEvents(options.region, options.num_random_events,
+                         options.sensing_ranges, &random, events);
+  } else {
+    GenerateGridEvents(options.region, options.event_grid_cols,
+                       options.event_grid_rows, options.sensing_ranges,
+                       events);
+  }
+}
+
+// Returns the cell of the event grid the position falls into.
+int GetHeatmapBin(const SimulationOptions& options, const Position& position) {
+  const Region& region = options.region;
+  int col = int((position.x - region.min_x) / (region.max_x - region.min_x) *
+                options.event_grid_cols);
+  int row = int((position.y - region.min_y) / (region.max_y - region.min_y) *
+                options.event_grid_rows);
+  col = std::min(std::max(col, 0), options.event_grid_cols - 1);
+  row = std::min(std::max(row, 0), options.event_grid_rows - 1);
+  return row * options.event_grid_cols + col;
+}
+
+// Distributions of the event-driven metrics over all events of all
+// repetitions, per communication range, builder, calculator and sensing
+// range, and the heatmaps of their averages over the event grid.
+//
+// The values of a communication range are only kept until all of its
+// repetitions are done. The thread which finishes the last repetition then
+// summarizes them in the order of the repetitions, so that the results do not
+// depend on the number of threads, while only the ranges in progress are held
+// in memory. Events which trigger no sensor only count as other values of
+// the statistics, and are left out of the heatmaps.
+class EventFieldMetrics {
+ public:
+  EventFieldMetrics(const SimulationOptions& options, int num_ranges)
+      : options_(options),
+        num_positions_(GetNumEventPositions(options)),
+        num_events_(num_positions_ * options.sensing_ranges.size()),
+        num_bins_(options.event_grid_cols * options.event_grid_rows),
+        num_groups_(options.builders.size() * options.event_calculators.size() *
+                    options.sensing_ranges.size()),
+        pending_(num_ranges),
+        summaries_(num_ranges, std::vector<MetricSummary>(num_groups_)),
+        heat_sums_(num_ranges),
+        heat_counts_(num_ranges) {
+  }
+
+  // Returns the array to store the metric values of the given simulation cell
+  // into, at index (builder * num_calculators + calculator) * num_events +
+  // event.
+  double* StartCell(int range_index,
+                    int repetition,
+                    const std::vector<Event>& events) {
+    assert(events.size() == num_events_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    PendingRange& range = pending_[range_index];
+    if (range.values.empty()) {
+      range.remaining = options_.times;
+      range.values.resize(options_.times * num_groups_ * num_positions_);
+      range.events.resize(options_.times);
+    }
+    range.events[repetition] = events;
+    return &range.values[repetition * num_groups_ * num_positions_];
+  }
+
+  void FinishCell(int range_index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_[range_index].remaining > 0) {
+        return;
+      }
+    }
+    Summarize(range_index);
+  }
+
+  const MetricSummary& GetSummary(int range_index, int builder,
+                                  int calculator, int sensing_range) const {
+    return summaries_[range_index][GetGroup(builder, calculator,
+                                            sensing_range)];
+  }
+
+  // Returns the average over all communication ranges of the events in the
+  // given cell of the event grid.
+  double GetHeat(int builder, int calculator, int sensing_range,
+                 int bin) const {
+    const int k =
+        GetGroup(builder, calculator, sensing_range) * num_bins_ + bin;
+    double sum = 0.0;
+    int count = 0;
+    for (int r = 0; r < heat_sums_.size(); r++) {
+      sum += heat_sums_[r][k];
+      count += heat_counts_[r][k];
+    }
+    return count > 0 ? sum / count : 0.0;
+  }
+
+ private:
+  struct PendingRange {
+    PendingRange() : remaining(0) {}
+
+    int remaining;
+    std::vector<std::vector<Event> > events;
+    std::vector<double> values;
+  };
+
+  // The values of a cell are grouped by builder, calculator and sensing
+  // range, in this order. The events of a sensing range are consecutive, so
+  // a group is also the offset of its values in units of num_positions_.
+  int GetGroup(int builder, int calculator, int sensing_range) const {
+    return (builder * options_.event_calculators.size() + calculator) *
+               options_.sensing_ranges.size() + sensing_range;
+  }
+
+  void Summarize(int range_index) {
+    PendingRange& range = pending_[range_index];
+    std::vector<double>& heat_sums = heat_sums_[range_index];
+    std::vector<int>& heat_counts = heat_counts_[range_index];
+    heat_sums.assign(num_groups_ * num_bins_, 0.0);
+    heat_counts.assign(num_groups_ * num_bins_, 0);
+
+    for (int g = 0; g < num_groups_; g++) {
+      MetricSummary& summary = summaries_[range_index][g];
+      for (int rep = 0; rep < options_.times; rep++) {
+        const double* values =
+            &range.values[(rep * num_groups_ + g) * num_positions_];
+        for (int i = 0; i < num_positions_; i++) {
+          summary.Add(values[i]);
+          if (values[i] > 0.0) {
+            int bin = GetHeatmapBin(options_, range.events[rep][i].position);
+            heat_sums[g * num_bins_ + bin] += values[i];
+            heat_counts[g * num_bins_ + bin]++;
+          }
+        }
+      }
+    }
+
+    // Release the values of the range. No other thread touches the range
+    // once all of its repetitions are done.
+    std::vector<double>().swap(range.values);
+    std::vector<std::vector<Event> >().swap(range.events);
+  }
+
+  const SimulationOptions& options_;
+  const int num_positions_;
+  const int num_events_;
+  const int num_bins_;
+  const int num_groups_;
+
+  std::mutex mutex_;
+  std::vector<PendingRange> pending_;
+
+  // range index -> group -> summary
+  std::vector<std::vector<MetricSummary> > summaries_;
+
+  // range index -> group * num_bins_ + bin -> sum and count of the values
+  std::vector<std::vector<double> > heat_sums_;
+  std::vector<std::vector<int> > heat_counts_;
+};
+
+// Same as CalculateMetrics(), except that the event-driven metrics are
+// evaluated for the whole event field of every simulation cell. The sensors
+// triggered by the events are found once per cell, and shared by all
+// calculators of all routings of the cell.
+void CalculateEventFieldMetrics(const SimulationOptions& options,
+                                EventFieldMetrics* metrics) {
+  const std::vector<double> ranges = GetCommunicationRanges(options);
+  const int num_builders = options.builders.size();
+  const int num_calculators = options.event_calculators.size();
+  const int num_cells = ranges.size() * options.times;
+
+  ParallelExecutor executor(options.num_threads);
+  std::vector<Workspace> workspaces(executor.num_workers());
+  ProgressPrinter progress(ranges, options.times);
+
+  executor.Run(num_cells, [&](int worker, int cell) {
+    ScopedTimer timer("simulation", "cell");
+    const int range_index = cell / options.times;
+    const int repetition = cell % options.times;
+    Workspace& workspace = workspaces[worker];
+    const SensorNetwork& network = workspace.network;
+    CellRouting& routing = workspace.routing;
+    EventBatch& batch = workspace.batch;
+    DeployCell(options, ranges[range_index], range_index, repetition,
+               &workspace);
+    {
+      ScopedTimer timer("simulation", "events");
+      GenerateCellEvents(options, range_index, repetition, &workspace.events);
+      batch.Build(network, workspace.events);
+    }
+
+    double* values =
+        metrics->StartCell(range_index, repetition, workspace.events);
+    for (int b = 0; b < num_builders; b++) {
+      BuildCellRouting(options, range_index, repetition, b, network, &routing);
+      for (int c = 0; c < num_calculators; c++) {
+        ScopedTimer timer("event-metric",
+                          options.event_calculators[c]->name().c_str());
+        options.event_calculators[c]->CalculateEventMetrics(
+            network, routing.view, batch, &workspace.metrics,
+            values + (b * num_calculators + c) * batch.num_events());
+      }
+    }
+    metrics->FinishCell(range_index);
+    progress.FinishRepetition(range_index);
+  });
+  printf("\n");
+}
+
+// Every line of an event field data file holds a communication range and a
+// sensing range, followed by the statistics of the metric over all events
+// for every builder, in the columns of a statistics file of SaveMetrics().
+// Events which trigger no sensor count as other values. The heatmap files of
+// every builder hold blocks of "x y value" lines, one block per sensing range,
+// with the average value of the events around (x, y) over all communication
+// ranges.
+void SaveEventFieldMetrics(const SimulationOptions& options,
+                           const EventFieldMetrics& metrics) {
+  const std::vector<double> ranges = GetCommunicationRanges(options);
+  const Region& region = options.region;
+  const double bin_width =
+      (region.max_x - region.min_x) / options.event_grid_cols;
+  const double bin_height =
+      (region.max_y - region.min_y) / options.event_grid_rows;
+
+  for (int c = 0; c < options.event_calculators.size(); c++) {
+    const std::string prefix =
+        "events-" + IntToString(options.num_sensors) + "-" +
+        options.event_calculators[c]->name();
+    const std::string filename = prefix + ".dat";
 
+    printf("Writing %s event field metrics to %s ...\n",
+           options.event_calculators[c]->name().c_str(), filename.c_str());
+
+    std::ofstream fs(filename.c_str());
+    for (int r = 0; r < ranges.size(); r++) {
+      for (int s = 0; s < options.sensing_ranges.size(); s++) {
+        fs << ranges[r] << " " << options.sensing_ranges[s];
+        for (int b = 0; b < options.builders.size(); b++) {
+          WriteMetricSummary(metrics.GetSummary(r, b, c, s), &fs);
+        }
+        fs << std::endl;
+      }
+    }
+
+    for (int b = 0; b < options.builders.size(); b++) {
+      const std::string heatmap_filename =
+          prefix + "-" + options.builders[b]->name() + "-heatmap.dat";
+      std::ofstream hs(heatmap_filename.c_str());
+      for (int s = 0; s < options.sensing_ranges.size(); s++) {
+        if (s > 0) {
+          hs << std::endl << std::endl;
+        }
+        hs << "# sensing range = " << options.sensing_ranges[s] << std::endl;
+        for (int row = 0; row < options.event_grid_rows; row++) {
+          for (int col = 0; col < options.event_grid_cols; col++) {
+            hs << region.min_x + (col + 0.5) * bin_width << " "
+               << region.min_y + (row + 0.5) * bin_height << " "
+               << metrics.GetHeat(b, c, s,
+                                  row * options.event_grid_cols + col)
+               << std::endl;
+          }
+          hs << std::endl;
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
   // Disable buffering of stdout.
   std::setbuf(stdout, NULL);
 
@@ -192,10 +1042,25 @@ int main(int argc, char** argv) {
 
   options.num_sensors = 100;
   options.times = 20;
+  options.num_threads = GetDefaultNumThreads();
+  options.seed = std::time(NULL);
 
   options.lower_communication_range = 25.0;
   options.upper_communication_range = 50.0;
   options.communication_range_step = 0.1;
+  options.max_failures = 5;
+  options.num_failure_orderings = 10;
+  options.common_placement = false;
+  options.placement_mode = kRegeneratePlacement;
+  options.large_scale = false;
+  // Leave the other half to the rest of the system.
+  options.memory_budget = GetPhysicalMemory() / 2;
+  if (options.memory_budget <= 0) {
+    options.memory_budget = int64_t(4) << 30;
+  }
+  options.event_grid_cols = 0;
+  options.event_grid_rows = 0;
+  options.num_random_events = 0;
 
   options.region.min_x = 0.0;
   options.region.min_y = 0.0;
@@ -211,41 +1076,188 @@ int main(int argc, char** argv) {
   options.builders.push_back(new RandomizedRoutingBuilder());
   options.builders.push_back(new WeightedRandomizedRoutingBuilder());
 
+  // Options start with "--" and may appear anywhere, the other arguments are
+  // positional.
+  std::vector<const char*> args;
+  int cell_range_index = -1;
+  int cell_repetition = -1;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    std::string value;
+    if (GetOptionValue(arg, "threads", &value)) {
+      options.num_threads = std::atoi(value.c_str());
+    } else if (GetOptionValue(arg, "seed", &value)) {
+      options.seed = std::strtoull(value.c_str(), NULL, 10);
+    } else if (GetOptionValue(arg, "max-failures", &value)) {
+      options.max_failures = std::max(1, std::atoi(value.c_str()));
+    } else if (GetOptionValue(arg, "failure-orderings", &value)) {
+      options.num_failure_orderings = std::atoi(value.c_str());
+    } else if (GetOptionValue(arg, "cell", &value)) {
+      if (std::sscanf(value.c_str(), "%d:%d",
+                      &cell_range_index, &cell_repetition) != 2) {
+        fprintf(stderr, "Invalid cell %s!\n", value.c_str());
+        exit(1);
+      }
+    } else if (arg == "--common-placement") {
+      options.common_placement = true;
+    } else if (GetOptionValue(arg, "placement", &value)) {
+      if (value == "regenerate") {
+        options.placement_mode = kRegeneratePlacement;
+      } else if (value == "repair") {
+        options.placement_mode = kRepairPlacement;
+      } else {
+        fprintf(stderr, "Invalid placement %s!\n", value.c_str());
+        exit(1);
+      }
+    } else if (GetOptionValue(arg, "raw-samples", &value)) {
+      options.raw_samples_filename = value;
+    } else if (GetOptionValue(arg, "event-grid", &value)) {
+      if (std::sscanf(value.c_str(), "%dx%d", &options.event_grid_cols,
+                      &options.event_grid_rows) != 2 ||
+          options.event_grid_cols <= 0 || options.event_grid_rows <= 0) {
+        fprintf(stderr, "Invalid event grid %s!\n", value.c_str());
+        exit(1);
+      }
+    } else if (GetOptionValue(arg, "random-events", &value)) {
+      options.num_random_events = std::atoi(value.c_str());
+    } else if (GetOptionValue(arg, "trace", &value)) {
+      options.trace_filename = value;
+    } else if (arg == "--large-scale") {
+      options.large_scale = true;
+    } else if (GetOptionValue(arg, "memory-budget", &value)) {
+      options.memory_budget = int64_t(std::atoll(value.c_str())) << 20;
+    } else if (GetOptionValue(arg, "sensing-ranges", &value)) {
+      options.sensing_ranges.clear();
+      const char* p = value.c_str();
+      char* end;
+      for (double range = std::strtod(p, &end); end != p;
+           range = std::strtod(p, &end)) {
+        options.sensing_ranges.push_back(range);
+        p = *end == ',' ? end + 1 : end;
+      }
+      if (options.sensing_ranges.empty() || *p != '\0') {
+        fprintf(stderr, "Invalid sensing ranges %s!\n", value.c_str());
+        exit(1);
+      }
+    } else if (arg.compare(0, 2, "--") == 0) {
+      fprintf(stderr, "Unknown option %s!\n", arg.c_str());
+      exit(1);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
+  if (args.size() > 0) {
+    options.num_sensors = std::atoi(args[0]);
+  }
+  if (args.size() > 1) {
+    options.times = std::atoi(args[1]);
+  }
+  if (args.size() > 3) {
+    options.lower_communication_range = std::atof(args[2]);
+    options.upper_communication_range = std::atof(args[3]);
+  }
+  if (args.size() > 4) {
+    options.communication_range_step = std::atof(args[4]);
+  }
+
   options.calculators.push_back(new NodeDegreeVarianceCalculator());
-  options.calculators.push_back(new RobustnessCalculator());
+  options.calculators.push_back(new RobustnessCalculator(options.max_failures));
+  options.calculators.push_back(new RandomFailureRobustnessCalculator(
+      options.max_failures, options.num_failure_orderings));
   options.calculators.push_back(new ChannelQualityCalculator());
   options.calculators.push_back(new DataAggregationCalculator());
   options.calculators.push_back(new LatencyCalculator());
 
-  if (argc > 1) {
-    options.num_sensors = std::atoi(argv[1]);
-  }
-  if (argc > 2) {
-    options.times = std::atoi(argv[2]);
-  }
-  if (argc > 4) {
-    options.lower_communication_range = std::atof(argv[3]);
-    options.upper_communication_range = std::atof(argv[4]);
+  if (options.event_grid_cols > 0 || options.num_random_events > 0) {
+    if (options.event_grid_cols == 0) {
+      options.event_grid_cols = 10;
+      options.event_grid_rows = 10;
+    }
+    if (options.sensing_ranges.empty()) {
+      options.sensing_ranges.push_back(GetDefaultEvent().sensing_range);
+    }
+    options.event_calculators.push_back(new ChannelQualityCalculator());
+    options.event_calculators.push_back(new DataAggregationCalculator());
+    options.event_calculators.push_back(new LatencyCalculator());
+
+    if (options.common_placement) {
+      fprintf(stderr, "Event field sweeps do not support common placements!\n");
+      exit(1);
+    }
   }
-  if (argc > 5) {
-    options.communication_range_step = std::atof(argv[5]);
+
+  if (options.large_scale) {
+    // Every thread simulates a network of its own.
+    const double bytes_per_thread =
+        EstimateBytesPerSensor(options) * options.num_sensors;
+    const int max_threads = int(options.memory_budget / bytes_per_thread);
+    if (max_threads < 1) {
+      fprintf(stderr, "A simulation takes about %.0f MB, more than the "
+              "memory budget!\n", bytes_per_thread / (1 << 20));
+      exit(1);
+    }
+    options.num_threads = std::min(options.num_threads, max_threads);
   }
 
   PrintSimulationOptions(options);
 
-  // Build example routing networks and save as SVG images. These example
-  // routing networks are only for demonstration purposes but not for the
-  // following simulations.
-  BuildExampleRoutingNetworks(options);
+  if (!options.trace_filename.empty() &&
+      !StartTracing(options.trace_filename)) {
+    fprintf(stderr, "Cannot open %s!\n", options.trace_filename.c_str());
+    exit(1);
+  }
+
+  if (cell_range_index >= 0) {
+    const std::string prefix =
+        "routings-" + IntToString(options.num_sensors) + "-cell-" +
+        IntToString(cell_range_index) + "-" + IntToString(cell_repetition) +
+        "-";
+    SaveCellRoutingNetworks(options, cell_range_index, cell_repetition,
+                            prefix, true);
+  } else if (IsEventFieldSweep(options)) {
+    BuildExampleRoutingNetworks(options);
+
+    EventFieldMetrics metrics(options, GetCommunicationRanges(options).size());
+    CalculateEventFieldMetrics(options, &metrics);
+    SaveEventFieldMetrics(options, metrics);
+  } else {
+    // Build example routing networks and save as SVG images. These example
+    // routing networks are only for demonstration purposes, and are the same
+    // as the ones of the first simulation cell.
+    BuildExampleRoutingNetworks(options);
+
+    RawSampleLog log;
+    if (!options.raw_samples_filename.empty() &&
+        !log.Open(options.raw_samples_filename)) {
+      fprintf(stderr, "Cannot open %s!\n",
+              options.raw_samples_filename.c_str());
+      exit(1);
+    }
+
+    RoutingMetrics metrics(options, GetCommunicationRanges(options).size());
+    CalculateMetrics(options, log.is_open() ? &log : NULL, &metrics);
+    SaveMetrics(options, metrics);
+  }
 
-  RoutingMetrics metrics(options);
-  CalculateMetrics(options, &metrics);
-  SaveMetrics(options, metrics);
+  // The names of the phases belong to the builders and calculators.
+  FinishTracing();
+
+  if (options.large_scale) {
+    const int64_t peak = GetPeakMemoryUsage();
+    printf("Peak memory: %lld MB, %.0f bytes per sensor per thread\n",
+           (long long) (peak >> 20),
+           double(peak) / options.num_sensors / options.num_threads);
+  }
 
   for (int i = 0; i < options.calculators.size(); i++) {
     delete options.calculators[i];
   }
 
+  for (int i = 0; i < options.event_calculators.size(); i++) {
+    delete options.event_calculators[i];
+  }
+
   for (int i = 0; i < options.builders.size(); i++) {
     delete options.builders[i];
   }
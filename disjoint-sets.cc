@@ -0,0 +1,49 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "disjoint-sets.h"
+
+#include <algorithm>
+
+void DisjointSets::Reset(int n) {
+  parents_.resize(n);
+  sizes_.assign(n, 1);
+  for (int i = 0; i < n; i++) {
+    parents_[i] = i;
+  }
+  num_sets_ = n;
+}
+
+int DisjointSets::Find(int x) {
+  while (parents_[x] != x) {
+    parents_[x] = parents_[parents_[x]];
+    x = parents_[x];
+  }
+  return x;
+}
+
+bool DisjointSets::Union(int x, int y) {
+  x = Find(x);
+  y = Find(y);
+  if (x == y) {
+    return false;
+  }
+  if (sizes_[x] < sizes_[y]) {
+    std::swap(x, y);
+  }
+  parents_[y] = x;
+  sizes_[x] += sizes_[y];
+  num_sets_--;
+  return true;
+}
+
+void DisjointSets::FindElementsOutsideSet(int x, std::vector<int>* elements) {
+  elements->clear();
+  x = Find(x);
+  for (int i = 0; i < parents_.size(); i++) {
+    if (Find(i) != x) {
+      elements->push_back(i);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_DISJOINT_SETS_H_
+#define NETWORKING_DISJOINT_SETS_H_
+
+#include <vector>
+
+// Union-find over the elements 0 .. n - 1, with union by size and path
+// halving.
+class DisjointSets {
+ public:
+  explicit DisjointSets(int n = 0) {
+    Reset(n);
+  }
+
+  // Puts every element back into a set of its own.
+  void Reset(int n);
+
+  int num_elements() const {
+    return parents_.size();
+  }
+
+  int num_sets() const {
+    return num_sets_;
+  }
+
+  // Returns the representative element of the set containing x.
+  int Find(int x);
+
+  // Merges the sets containing x and y. Returns false if they are already in
+  // the same set.
+  bool Union(int x, int y);
+
+  int GetSetSize(int x) {
+    return sizes_[Find(x)];
+  }
+
+  // Replaces elements with the elements outside the set containing x, in
+  // ascending order.
+  void FindElementsOutsideSet(int x, std::vector<int>* elements);
+
+ private:
+  std::vector<int> parents_;
+  std::vector<int> sizes_;
+  int num_sets_;
+};
+
+#endif  // NETWORKING_DISJOINT_SETS_H_
@@ -20,6 +20,7 @@ fi
 
 ./draw-metrics-node-degree-variance.sh "${@}"
 ./draw-metrics-robustness.sh "${@}"
+./draw-metrics-random-failure-robustness.sh "${@}"
 ./draw-metrics-channel-quality.sh "${@}"
 ./draw-metrics-data-aggregation.sh "${@}"
 ./draw-metrics-latency.sh "${@}"
@@ -0,0 +1,83 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "events.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "sensor-network.h"
+
+Event GetDefaultEvent() {
+  // FIXME: derive it from the region of the network.
+  return Event(Position(50.0, 50.0), 15.0);
+}
+
+void GenerateGridEvents(const Region& region,
+                        int num_cols,
+                        int num_rows,
+                        const std::vector<double>& sensing_ranges,
+                        std::vector<Event>* events) {
+  assert(events != NULL);
+  assert(num_cols > 0 && num_rows > 0);
+  events->clear();
+  const double width = (region.max_x - region.min_x) / num_cols;
+  const double height = (region.max_y - region.min_y) / num_rows;
+  for (int s = 0; s < sensing_ranges.size(); s++) {
+    for (int row = 0; row < num_rows; row++) {
+      for (int col = 0; col < num_cols; col++) {
+        Position position(region.min_x + (col + 0.5) * width,
+                          region.min_y + (row + 0.5) * height);
+        events->push_back(Event(position, sensing_ranges[s]));
+      }
+    }
+  }
+}
+
+void GenerateRandomEvents(const Region& region,
+                          int num_positions,
+                          const std::vector<double>& sensing_ranges,
+                          Random* random,
+                          std::vector<Event>* events) {
+  assert(random != NULL);
+  assert(events != NULL);
+  events->clear();
+  if (sensing_ranges.empty()) {
+    return;
+  }
+
+  // The positions are drawn a block at a time for the first sensing range,
+  // and then copied for the others, so that they take no memory from the
+  // heap.
+  const int kBlockSize = 256;
+  double numbers[2 * kBlockSize];
+  for (int first = 0; first < num_positions; first += kBlockSize) {
+    const int count = std::min(kBlockSize, num_positions - first);
+    random->FillDoubles(2 * count, numbers);
+    for (int i = 0; i < count; i++) {
+      Position position(
+          region.min_x + numbers[2 * i] * (region.max_x - region.min_x),
+          region.min_y + numbers[2 * i + 1] * (region.max_y - region.min_y));
+      events->push_back(Event(position, sensing_ranges[0]));
+    }
+  }
+  for (int s = 1; s < sensing_ranges.size(); s++) {
+    for (int i = 0; i < num_positions; i++) {
+      events->push_back(Event((*events)[i].position, sensing_ranges[s]));
+    }
+  }
+}
+
+void EventBatch::Build(const SensorNetwork& network,
+                       const std::vector<Event>& events) {
+  events_ = events;
+  offsets_.resize(events_.size() + 1);
+  offsets_[0] = 0;
+  triggered_.clear();
+  for (int e = 0; e < events_.size(); e++) {
+    network.grid().FindSensorsWithinRange(
+        events_[e].position, events_[e].sensing_range, &triggered_);
+    offsets_[e + 1] = triggered_.size();
+  }
+}
@@ -0,0 +1,84 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_EVENTS_H_
+#define NETWORKING_EVENTS_H_
+
+#include <vector>
+
+#include "position.h"
+#include "random.h"
+#include "region.h"
+#include "span.h"
+
+class SensorNetwork;
+
+// An event at a position, which triggers all sensors within its sensing range.
+struct Event {
+  Event(const Position& position, double sensing_range)
+      : position(position), sensing_range(sensing_range) {}
+
+  Position position;
+  double sensing_range;
+};
+
+// Returns the single event the event-driven metrics are calculated for by
+// default.
+Event GetDefaultEvent();
+
+// Replaces events with one event at the center of every cell of a num_cols x
+// num_rows grid over the region, for each of the sensing ranges. The events of
+// the first sensing range come first, each group in row-major order of cells.
+void GenerateGridEvents(const Region& region,
+                        int num_cols,
+                        int num_rows,
+                        const std::vector<double>& sensing_ranges,
+                        std::vector<Event>* events);
+
+// Replaces events with num_positions events at random positions within the
+// region for each of the sensing ranges, in the same layout as
+// GenerateGridEvents(). The positions are the same for every sensing range.
+void GenerateRandomEvents(const Region& region,
+                          int num_positions,
+                          const std::vector<double>& sensing_ranges,
+                          Random* random,
+                          std::vector<Event>* events);
+
+// A batch of events together with the sensors triggered by every one of them.
+// The triggered sensors are found once through the spatial index of the
+// network, and then shared by all event-driven metrics of all routings of the
+// network.
+class EventBatch {
+ public:
+  EventBatch() {}
+
+  // Finds the sensors of the network triggered by every event. The sensors of
+  // the network must not move while the batch is in use.
+  void Build(const SensorNetwork& network, const std::vector<Event>& events);
+
+  int num_events() const {
+    return events_.size();
+  }
+
+  const Event& GetEvent(int event) const {
+    return events_[event];
+  }
+
+  // Returns the IDs of the sensors triggered by the event, in ascending
+  // order.
+  Span<int> GetTriggeredSensors(int event) const {
+    return Span<int>(triggered_.data() + offsets_[event],
+                     triggered_.data() + offsets_[event + 1]);
+  }
+
+ private:
+  std::vector<Event> events_;
+
+  // The sensors triggered by event e are triggered_[offsets_[e]] ..
+  // triggered_[offsets_[e + 1] - 1].
+  std::vector<int> offsets_;
+  std::vector<int> triggered_;
+};
+
+#endif  // NETWORKING_EVENTS_H_
@@ -0,0 +1,81 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "parallel-executor.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+ParallelExecutor::ParallelExecutor(int num_workers)
+    : num_workers_(std::max(num_workers, 1)), queues_(num_workers_) {
+}
+
+void ParallelExecutor::Run(int num_tasks, const Task& task) {
+  if (num_workers_ == 1) {
+    for (int i = 0; i < num_tasks; i++) {
+      task(0, i);
+    }
+    return;
+  }
+
+  for (int w = 0; w < num_workers_; w++) {
+    int begin = int(int64_t(num_tasks) * w / num_workers_);
+    int end = int(int64_t(num_tasks) * (w + 1) / num_workers_);
+    std::deque<int>& tasks = queues_[w].tasks;
+    tasks.clear();
+    for (int i = begin; i < end; i++) {
+      tasks.push_back(i);
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (int w = 1; w < num_workers_; w++) {
+    threads.push_back(std::thread(&ParallelExecutor::Work, this, w,
+                                  std::cref(task)));
+  }
+  Work(0, task);
+  for (int i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+}
+
+void ParallelExecutor::Work(int worker, const Task& task) {
+  int i;
+  while (PopTask(worker, &i) || StealTask(worker, &i)) {
+    task(worker, i);
+  }
+}
+
+bool ParallelExecutor::PopTask(int worker, int* task) {
+  WorkQueue& queue = queues_[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  *task = queue.tasks.front();
+  queue.tasks.pop_front();
+  return true;
+}
+
+// Tasks are never added once running, so a worker that finds every other
+// queue empty can stop.
+bool ParallelExecutor::StealTask(int worker, int* task) {
+  for (int i = 1; i < num_workers_; i++) {
+    WorkQueue& queue = queues_[(worker + i) % num_workers_];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      *task = queue.tasks.back();
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+int GetDefaultNumThreads() {
+  return std::max(1, int(std::thread::hardware_concurrency()));
+}
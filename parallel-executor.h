@@ -0,0 +1,58 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_PARALLEL_EXECUTOR_H_
+#define NETWORKING_PARALLEL_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs independent tasks on a fixed number of worker threads.
+//
+// The tasks are split into contiguous blocks, one per worker. A worker takes
+// tasks from the front of its own block, and once that runs out steals from
+// the back of the other workers' blocks, so uneven task costs still keep every
+// worker busy.
+class ParallelExecutor {
+ public:
+  // Runs the given task for every task index in [0, num_tasks). The worker
+  // index in [0, num_workers) passed along lets the task use per-worker state
+  // without locking.
+  typedef std::function<void(int worker, int task)> Task;
+
+  explicit ParallelExecutor(int num_workers);
+
+  int num_workers() const {
+    return num_workers_;
+  }
+
+  // Returns after all tasks are done. With a single worker the tasks run on
+  // the calling thread in ascending order.
+  void Run(int num_tasks, const Task& task);
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  // Runs tasks until there are none left in any queue.
+  void Work(int worker, const Task& task);
+
+  bool PopTask(int worker, int* task);
+
+  bool StealTask(int worker, int* task);
+
+  const int num_workers_;
+
+  std::vector<WorkQueue> queues_;
+};
+
+// Returns the number of threads the hardware can run concurrently, or 1 if
+// unknown.
+int GetDefaultNumThreads();
+
+#endif  // NETWORKING_PARALLEL_EXECUTOR_H_
@@ -0,0 +1,189 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "parent-candidates.h"
+
+#include <cassert>
+
+#include "bit-matrix.h"
+#include "sensor-network.h"
+#include "trace.h"
+
+bool ParentCandidates::Build(const SensorNetwork& network) {
+  ScopedTimer timer("network", "parent-candidates");
+  const int n = network.num_sensors();
+  levels_.assign(n, -1);
+  offsets_.assign(n + 1, 0);
+  queue_.clear();
+  queue_.reserve(n);
+
+  if (network.has_neighbor_bits()) {
+    BuildFromNeighborBits(network);
+  } else {
+    BuildFromNeighbors(network);
+  }
+  if (IsTracing()) {
+    TraceFrontiers();
+  }
+  return queue_.size() == n;
+}
+
+void ParentCandidates::BuildFromNeighbors(const SensorNetwork& network) {
+  const int n = network.num_sensors();
+
+  // The first pass assigns the levels and counts the candidates.
+  levels_[0] = 0;
+  queue_.push_back(0);  // Start from the base station.
+  for (int head = 0; head < queue_.size(); head++) {
+    const int current = queue_[head];
+    const int level = levels_[current];
+    Span<int> neighbors = network.GetNeighbors(current);
+    for (const int* it = neighbors.begin(); it != neighbors.end(); ++it) {
+      const int neighbor = *it;
+      if (levels_[neighbor] == -1) {
+        levels_[neighbor] = level + 1;
+        queue_.push_back(neighbor);
+      }
+      if (levels_[neighbor] == level + 1) {
+        offsets_[neighbor + 1]++;
+      }
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    offsets_[i + 1] += offsets_[i];
+  }
+
+  // The second pass visits the sensors in the same order, so that every
+  // sensor receives its candidates in BFS order.
+  candidates_.resize(offsets_[n]);
+  distances_.resize(offsets_[n]);
+  next_.assign(offsets_.begin(), offsets_.end() - 1);
+  for (int head = 0; head < queue_.size(); head++) {
+    const int current = queue_[head];
+    const int level = levels_[current];
+    Span<int> neighbors = network.GetNeighbors(current);
+    for (const int* it = neighbors.begin(); it != neighbors.end(); ++it) {
+      const int neighbor = *it;
+      if (levels_[neighbor] == level + 1) {
+        candidates_[next_[neighbor]] = current;
+        distances_[next_[neighbor]] = network.GetDistance(current, neighbor);
+        next_[neighbor]++;
+      }
+    }
+  }
+}
+
+// Same as BuildFromNeighbors(), with the same results, but every pass over the
+// neighbors of a sensor is a pass over the words of its row, masked with the
+// sensors of interest: the unvisited ones while searching, then the sensors of
+// the level before or after it.
+void ParentCandidates::BuildFromNeighborBits(const SensorNetwork& network) {
+  const int n = network.num_sensors();
+  const BitMatrix& neighbor_bits = network.neighbor_bits();
+  const int num_words = neighbor_bits.words_per_row();
+
+  // The first pass assigns the levels. Reached sensors are appended in
+  // ascending order of IDs, like the neighbors of a row.
+  std::vector<uint64_t>& unvisited = level_bits_;
+  unvisited.assign(num_words, ~uint64_t(0));
+  unvisited[0] &= ~uint64_t(1);
+  levels_[0] = 0;
+  queue_.push_back(0);  // Start from the base station.
+  for (int head = 0; head < queue_.size(); head++) {
+    const int current = queue_[head];
+    const int level = levels_[current];
+    const uint64_t* row = neighbor_bits.GetRow(current);
+    for (int w = 0; w < num_words; w++) {
+      uint64_t reached = row[w] & unvisited[w];
+      unvisited[w] &= ~reached;
+      for (; reached != 0; reached &= reached - 1) {
+        const int neighbor = w * 64 + GetLowestBit(reached);
+        levels_[neighbor] = level + 1;
+        queue_.push_back(neighbor);
+      }
+    }
+  }
+
+  // The queue holds the sensors level by level. The candidates of a sensor
+  // are its neighbors of the level before it, and the sensors which have the
+  // current sensor as a candidate are its neighbors of the level after it.
+  std::vector<uint64_t>& previous_level = level_bits_;
+  std::vector<uint64_t>& next_level = next_level_bits_;
+  GetLevelBits(0, 0, &previous_level);
+  for (int begin = 0; begin < queue_.size();) {
+    const int end = FindLevelEnd(begin);
+    for (int k = begin; k < end; k++) {
+      const uint64_t* row = neighbor_bits.GetRow(queue_[k]);
+      int count = 0;
+      for (int w = 0; w < num_words; w++) {
+        count += CountBits(row[w] & previous_level[w]);
+      }
+      offsets_[queue_[k] + 1] = count;
+    }
+    GetLevelBits(begin, end, &previous_level);
+    begin = end;
+  }
+  for (int i = 0; i < n; i++) {
+    offsets_[i + 1] += offsets_[i];
+  }
+
+  // The second pass visits the sensors in the same order, so that every
+  // sensor receives its candidates in BFS order.
+  candidates_.resize(offsets_[n]);
+  distances_.resize(offsets_[n]);
+  next_.assign(offsets_.begin(), offsets_.end() - 1);
+  for (int begin = 0; begin < queue_.size();) {
+    const int end = FindLevelEnd(begin);
+    GetLevelBits(end, FindLevelEnd(end), &next_level);
+    for (int k = begin; k < end; k++) {
+      const int current = queue_[k];
+      const uint64_t* row = neighbor_bits.GetRow(current);
+      for (int w = 0; w < num_words; w++) {
+        for (uint64_t bits = row[w] & next_level[w]; bits != 0;
+             bits &= bits - 1) {
+          const int neighbor = w * 64 + GetLowestBit(bits);
+          candidates_[next_[neighbor]] = current;
+          distances_[next_[neighbor]] = network.GetDistance(current, neighbor);
+          next_[neighbor]++;
+        }
+      }
+    }
+    begin = end;
+  }
+}
+
+int ParentCandidates::FindLevelEnd(int begin) const {
+  if (begin == queue_.size()) {
+    return begin;
+  }
+  const int level = levels_[queue_[begin]];
+  int end = begin + 1;
+  while (end < queue_.size() && levels_[queue_[end]] == level) {
+    end++;
+  }
+  return end;
+}
+
+void ParentCandidates::GetLevelBits(int begin, int end,
+                                    std::vector<uint64_t>* bits) const {
+  bits->assign(BitMatrix::GetNumWords(levels_.size()), 0);
+  for (int k = begin; k < end; k++) {
+    (*bits)[queue_[k] / 64] |= uint64_t(1) << (queue_[k] % 64);
+  }
+}
+
+void ParentCandidates::TraceFrontiers() const {
+  // The queue holds the sensors level by level, so every frontier of the BFS
+  // is a run of sensors of the same level.
+  int num_levels = 0;
+  int begin = 0;
+  for (int i = 1; i <= queue_.size(); i++) {
+    if (i == queue_.size() || levels_[queue_[i]] != levels_[queue_[begin]]) {
+      TraceCounter("bfs-frontier", i - begin);
+      num_levels++;
+      begin = i;
+    }
+  }
+  TraceCounter("bfs-levels", num_levels);
+}
@@ -0,0 +1,93 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_PARENT_CANDIDATES_H_
+#define NETWORKING_PARENT_CANDIDATES_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "position.h"
+#include "span.h"
+
+class SensorNetwork;
+
+// BFS levels of all sensors from the base station, and the parent candidates
+// of every sensor, i.e. its neighbors one level closer to the base station.
+//
+// They only depend on the channels of the network, so they are computed once
+// per deployment and shared by all routing builders. The candidates are kept
+// in compressed sparse row form, in the order in which the BFS first reached
+// the sensor from them, since some builders select by that order. Building
+// them again reuses the memory of the previous ones.
+//
+// The BFS walks the neighbor lists of the sensors, or the rows of the
+// neighbor bits of a dense network, see SensorNetwork::neighbor_bits().
+class ParentCandidates {
+ public:
+  ParentCandidates() {}
+
+  // Runs the BFS over the channels of the network. Returns whether all
+  // sensors are reached.
+  bool Build(const SensorNetwork& network);
+
+  // Returns whether the BFS reached all sensors.
+  bool IsConnected() const {
+    return queue_.size() == levels_.size();
+  }
+
+  // Returns the BFS level of the sensor, or -1 if it is not reached.
+  int GetLevel(int sensor) const {
+    return levels_[sensor];
+  }
+
+  // Returns the parent candidates of the sensor in BFS order. The base
+  // station has none.
+  Span<int> GetCandidates(int sensor) const {
+    return Span<int>(candidates_.data() + offsets_[sensor],
+                     candidates_.data() + offsets_[sensor + 1]);
+  }
+
+  // Returns the distances to the parent candidates of the sensor, in the same
+  // order as GetCandidates().
+  Span<Scalar> GetCandidateDistances(int sensor) const {
+    return Span<Scalar>(distances_.data() + offsets_[sensor],
+                        distances_.data() + offsets_[sensor + 1]);
+  }
+
+ private:
+  void BuildFromNeighbors(const SensorNetwork& network);
+
+  void BuildFromNeighborBits(const SensorNetwork& network);
+
+  // Returns the end of the run of sensors of the same level in queue_ which
+  // starts at begin.
+  int FindLevelEnd(int begin) const;
+
+  // Replaces bits with the bits of the sensors in [begin, end) of queue_.
+  void GetLevelBits(int begin, int end, std::vector<uint64_t>* bits) const;
+
+  // Records the number of sensors of every level of the BFS.
+  void TraceFrontiers() const;
+
+  std::vector<int> levels_;
+  std::vector<int> offsets_;
+  std::vector<int> candidates_;
+  std::vector<Scalar> distances_;
+
+  // sensors in BFS order, which is also the queue of the BFS.
+  std::vector<int> queue_;
+
+  // next free slot in the candidates of every sensor, while building them.
+  // It is kept to reuse its memory for the next network.
+  std::vector<int> next_;
+
+  // bits of the sensors of two levels, or of the unvisited sensors, while
+  // building from neighbor bits.
+  std::vector<uint64_t> level_bits_;
+  std::vector<uint64_t> next_level_bits_;
+};
+
+#endif  // NETWORKING_PARENT_CANDIDATES_H_
@@ -6,7 +6,8 @@
 
 #include <cmath>
 
-bool operator<(const Position& lhs, const Position& rhs) {
+template <typename T>
+bool operator<(const BasicPosition<T>& lhs, const BasicPosition<T>& rhs) {
   if (lhs.y != rhs.y) {
     return lhs.y < rhs.y;
   } else {
@@ -14,9 +15,19 @@ bool operator<(const Position& lhs, const Position& rhs) {
   }
 }
 
-double Distance(const Position& lhs, const Position& rhs) {
-  double dx = lhs.x - rhs.x;
-  double dy = lhs.y - rhs.y;
+template <typename T>
+T Distance(const BasicPosition<T>& lhs, const BasicPosition<T>& rhs) {
+  T dx = lhs.x - rhs.x;
+  T dy = lhs.y - rhs.y;
   return std::sqrt(dx * dx + dy * dy);
 }
 
+template bool operator<(const BasicPosition<float>&,
+                        const BasicPosition<float>&);
+template bool operator<(const BasicPosition<double>&,
+                        const BasicPosition<double>&);
+
+template float Distance(const BasicPosition<float>&,
+                        const BasicPosition<float>&);
+template double Distance(const BasicPosition<double>&,
+                         const BasicPosition<double>&);
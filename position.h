@@ -5,15 +5,31 @@
 #ifndef NETWORKING_POSITION_H_
 #define NETWORKING_POSITION_H_
 
-struct Position {
-  Position(double x, double y) : x(x), y(y) {}
+// Scalar type of the positions of the sensors and the distances between them,
+// chosen by the build, see SCALAR in the Makefile. float halves the memory
+// traffic of the distance and neighbor search kernels, but positions and
+// distances are only accurate to about 7 significant digits.
+#ifndef NETWORKING_SCALAR
+#define NETWORKING_SCALAR double
+#endif
 
-  double x;
-  double y;
+typedef NETWORKING_SCALAR Scalar;
+
+template <typename T>
+struct BasicPosition {
+  BasicPosition(T x, T y) : x(x), y(y) {}
+
+  T x;
+  T y;
 };
 
-double Distance(const Position&, const Position&);
+typedef BasicPosition<Scalar> Position;
+
+// Instantiated for float and double.
+template <typename T>
+T Distance(const BasicPosition<T>&, const BasicPosition<T>&);
 
-bool operator<(const Position&, const Position&);
+template <typename T>
+bool operator<(const BasicPosition<T>&, const BasicPosition<T>&);
 
 #endif  // NETWORKING_POSITION_H_
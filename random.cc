@@ -0,0 +1,67 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "random.h"
+
+#include <cassert>
+
+namespace {
+
+const uint64_t kGoldenGamma = 0x9e3779b97f4a7c15ULL;
+
+// Finalizer of SplitMix64, which maps every 64-bit integer to a well mixed
+// one.
+uint64_t Mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Maps the top 53 bits to a double in [0, 1).
+double ToDouble(uint64_t n) {
+  return (n >> 11) * (1.0 / 9007199254740992.0);
+}
+
+}  // namespace
+
+Random::Random(uint64_t seed) : key_(Mix(seed)), counter_(0) {
+}
+
+Random Random::ForCell(uint64_t seed,
+                       int range_index,
+                       int repetition,
+                       RandomPurpose purpose,
+                       int index) {
+  uint64_t key = Mix(seed);
+  key = Mix(key + (uint64_t(range_index) + 1) * kGoldenGamma);
+  key = Mix(key + (uint64_t(repetition) + 1) * kGoldenGamma);
+  key = Mix(key + (uint64_t(purpose) + 1) * kGoldenGamma);
+  key = Mix(key + (uint64_t(index) + 1) * kGoldenGamma);
+  return Random(key);
+}
+
+uint64_t Random::Next() {
+  return Mix(key_ + ++counter_ * kGoldenGamma);
+}
+
+double Random::NextDouble(double min, double max) {
+  return min + ToDouble(Next()) * (max - min);
+}
+
+int Random::NextInt(int n) {
+  assert(n > 0);
+  return Next() % n;
+}
+
+void Random::FillDoubles(int n, std::vector<double>* values) {
+  values->resize(n);
+  FillDoubles(n, values->data());
+}
+
+void Random::FillDoubles(int n, double* values) {
+  for (int i = 0; i < n; i++) {
+    values[i] = ToDouble(Mix(key_ + (counter_ + i + 1) * kGoldenGamma));
+  }
+  counter_ += n;
+}
@@ -0,0 +1,64 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_RANDOM_H_
+#define NETWORKING_RANDOM_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+// What a random number stream is used for. Every purpose of a simulation cell
+// has its own stream, so that e.g. the sensor positions do not change when a
+// routing builder draws more or fewer numbers.
+enum RandomPurpose {
+  kPlacementPurpose = 0,
+  kRoutingPurpose = 1,
+  kMetricPurpose = 2,
+  kEventPurpose = 3,
+};
+
+// Counter-based pseudo random number generator in the style of SplitMix64.
+//
+// The n-th number of a stream is a hash of the stream key and n, so streams
+// are independent of each other, and any stream can be recreated from its
+// key alone, without replaying the numbers drawn before it. Unlike
+// std::rand(), every generator has its own state, so simulations on different
+// threads do not share anything.
+class Random {
+ public:
+  explicit Random(uint64_t seed);
+
+  // Returns the stream for the given purpose of the simulation cell with the
+  // given range index and repetition. The index tells apart multiple streams
+  // of the same purpose, e.g. one per routing builder.
+  static Random ForCell(uint64_t seed,
+                        int range_index,
+                        int repetition,
+                        RandomPurpose purpose,
+                        int index = 0);
+
+  // Returns a random 64-bit integer.
+  uint64_t Next();
+
+  // Returns a double random number in [min, max).
+  double NextDouble(double min, double max);
+
+  // Returns a random integer in [0, n).
+  int NextInt(int n);
+
+  // Replaces values with n double random numbers in [0, 1). The numbers are
+  // the same as n calls of NextDouble(0.0, 1.0), but computed without a
+  // dependency from one number to the next.
+  void FillDoubles(int n, std::vector<double>* values);
+
+  // Same as above, but stores the numbers into the array values.
+  void FillDoubles(int n, double* values);
+
+ private:
+  const uint64_t key_;
+  uint64_t counter_;
+};
+
+#endif  // NETWORKING_RANDOM_H_
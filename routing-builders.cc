@@ -6,322 +6,224 @@
 
 #include <algorithm>
 #include <cassert>
-#include <cmath>
 #include <cstdlib>
-#include <cstring>
-#include <ctime>
-#include <iterator>
-#include <map>
-#include <queue>
-#include <set>
+#include <vector>
 
+#include "parent-candidates.h"
+#include "random.h"
+#include "routing-tree.h"
 #include "sensor-network.h"
-#include "utils.h"
+#include "span.h"
+#include "trace.h"
 
-class ParentSelector {
- public:
-  virtual ~ParentSelector() {}
+// A selector is created once per routing, and selects the parent of every
+// sensor but the base station from its parent candidates in BFS order, and
+// the distances to them. kDeterminedByCandidates tells whether that is all
+// the selection depends on, see RoutingBuilder::IsDeterminedByCandidates().
 
-  // Returns the selected parent.
-  virtual int SelectParent(int sensor,
-                           const std::vector<int>& candidates,
-                           const SensorNetwork& network) = 0;
-};
-
-// We use a vector instead of a set to store parent candidates for each sensor
-// because in some routing topology generating algorithms, the order in which a
-// parent first reaches a sensor matters.
-bool GenerateParentCandidates(SensorNetwork* network,
-                              std::vector<std::vector<int> >* parents) {
-  parents->clear();
-  parents->resize(network->num_sensors());
-
-  std::vector<bool> visited(network->num_sensors());
-  int num_visited = 0;
-  network->SetLevel(0, 0);
-  std::queue<int> queue;
-  visited[0] = true;
-  num_visited++;
-  queue.push(0);  // Start from the base station.
-  while (!queue.empty()) {
-    int current = queue.front();
-    queue.pop();
-    int level = network->GetLevel(current);
-    const std::set<int>& neighbors = network->GetNeighbors(current);
-    for (std::set<int>::const_iterator it = neighbors.begin();
-         it != neighbors.end();
-         ++it) {
-      int neighbor = *it;
-      int neighbor_level = network->GetLevel(neighbor);
-      if (neighbor_level == -1 || neighbor_level > level) {
-        if (neighbor_level == -1) {
-          network->SetLevel(neighbor, level + 1);
-        } else {
-          assert(neighbor_level == level + 1);
-        }
-        std::vector<int>& neighbor_parents = (*parents)[neighbor];
-        assert(std::find(neighbor_parents.begin(),
-                         neighbor_parents.end(),
-                         current) == neighbor_parents.end());
-        neighbor_parents.push_back(current);
-        if (!visited[neighbor]) {
-          queue.push(neighbor);
-          visited[neighbor] = true;
-          num_visited++;
-        }
-      }
-    }
-  }
-
-  return num_visited == network->num_sensors();
-}
+struct EarliestFirstSelector {
+  static const char* name() { return "earliest-first"; }
+  static const char* title() { return "Earliest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-RoutingBuilder::~RoutingBuilder() {
-  delete selector_;
-}
+  EarliestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-void RoutingBuilder::BuildRouting(SensorNetwork* network) {
-  network->RemoveParents();
-  std::vector<std::vector<int> > candidates;
-  bool succeeded = GenerateParentCandidates(network, &candidates);
-  assert(succeeded);
-
-  // Base station does not need to and cannot select parent.
-  for (int i = 1; i < network->num_sensors(); i++) {
-    network->SetParent(i, selector_->SelectParent(i, candidates[i], *network));
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    return candidates.front();
   }
-  // Make sure the routing generator works as expected.
-  assert(network->IsConnectedWithRoutings());
-}
-
-class EarliestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
 };
 
-int EarliestFirstParentSelector::SelectParent(int sensor,
-                                              const std::vector<int>& candidates,
-                                              const SensorNetwork& network) {
-  assert(!candidates.empty());
-  return candidates.front();
-}
+// Selects the earliest candidate if there is only one.
+struct SecondEarliestFirstSelector {
+  static const char* name() { return "second-earliest-first"; }
+  static const char* title() { return "Second Earliest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-EarliestFirstRoutingBuilder::EarliestFirstRoutingBuilder()
-    : RoutingBuilder("earliest-first",
-                     "Earliest First Routing",
-                     new EarliestFirstParentSelector()) {
-}
+  SecondEarliestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-class SecondEarliestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    return candidates.size() == 1 ? candidates[0] : candidates[1];
+  }
 };
 
-int SecondEarliestFirstParentSelector::SelectParent(
-    int sensor,
-    const std::vector<int>& candidates,
-    const SensorNetwork& network) {
-  assert(!candidates.empty());
-  if (candidates.size() == 1) {
-    return candidates.front();
-  } else {
-    return candidates[1];
-  }
-}
+struct LatestFirstSelector {
+  static const char* name() { return "latest-first"; }
+  static const char* title() { return "Latest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-SecondEarliestFirstRoutingBuilder::SecondEarliestFirstRoutingBuilder()
-    : RoutingBuilder("second-earliest-first",
-                     "Second Earliest First Routing",
-                     new SecondEarliestFirstParentSelector()) {
-}
+  LatestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-class LatestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    return candidates.back();
+  }
 };
 
-int LatestFirstParentSelector::SelectParent(int sensor,
-                                            const std::vector<int>& candidates,
-                                            const SensorNetwork& network) {
-  assert(!candidates.empty());
-  return candidates.back();
-}
+// Of candidates at the same distance, the earliest one is selected.
+struct NearestFirstSelector {
+  static const char* name() { return "nearest-first"; }
+  static const char* title() { return "Nearest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-LatestFirstRoutingBuilder::LatestFirstRoutingBuilder()
-    : RoutingBuilder("latest-first",
-                     "Latest First Routing",
-                     new LatestFirstParentSelector()) {
-}
+  NearestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-class RandomizedParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    int parent = 0;
+    for (int i = 1; i < candidates.size(); i++) {
+      if (distances[i] < distances[parent]) {
+        parent = i;
+      }
+    }
+    return candidates[parent];
+  }
 };
 
-int RandomizedParentSelector::SelectParent(int sensor,
-                                           const std::vector<int>& candidates,
-                                           const SensorNetwork& network) {
-  assert(!candidates.empty());
-  return candidates[std::rand() % candidates.size()];
-}
+// Selects the nearest candidate if there is only one.
+struct SecondNearestFirstSelector {
+  static const char* name() { return "second-nearest-first"; }
+  static const char* title() { return "Second Nearest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-RandomizedRoutingBuilder::RandomizedRoutingBuilder()
-    : RoutingBuilder("randomized",
-                     "Randomized Routing",
-                     new RandomizedParentSelector()) {
-}
+  SecondNearestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-class NearestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
-};
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    if (candidates.size() == 1) {
+      return candidates[0];
+    }
 
-int NearestFirstParentSelector::SelectParent(int sensor,
-                                             const std::vector<int>& candidates,
-                                             const SensorNetwork& network) {
-  assert(!candidates.empty());
-  int parent = candidates[0];
-  double min_distance = network.GetDistance(sensor, parent);
-  for (int i = 1; i < candidates.size(); i++) {
-    double distance = network.GetDistance(sensor, candidates[i]);
-    if (distance < min_distance) {
-      parent = candidates[i];
-      min_distance = distance;
+    int first = 0;
+    int second = 1;
+    if (distances[second] < distances[first]) {
+      std::swap(first, second);
     }
+    for (int i = 2; i < candidates.size(); i++) {
+      if (distances[i] < distances[first]) {
+        second = first;
+        first = i;
+      } else if (distances[i] < distances[second]) {
+        second = i;
+      }
+    }
+    return candidates[second];
   }
+};
 
-  return parent;
-}
+// Of candidates at the same distance, the earliest one is selected.
+struct FarthestFirstSelector {
+  static const char* name() { return "farthest-first"; }
+  static const char* title() { return "Farthest First Routing"; }
+  static const bool kDeterminedByCandidates = true;
 
-NearestFirstRoutingBuilder::NearestFirstRoutingBuilder()
-    : RoutingBuilder("nearest-first",
-                     "Nearest First Routing",
-                     new NearestFirstParentSelector()) {
-}
+  FarthestFirstSelector(const SensorNetwork& network, Random* random) {}
 
-class SecondNearestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    int parent = 0;
+    for (int i = 1; i < candidates.size(); i++) {
+      if (distances[i] > distances[parent]) {
+        parent = i;
+      }
+    }
+    return candidates[parent];
+  }
 };
 
-int SecondNearestFirstParentSelector::SelectParent(
-    int sensor,
-    const std::vector<int>& candidates,
-    const SensorNetwork& network) {
-  assert(!candidates.empty());
-  if (candidates.size() == 1) {
-    return candidates[0];
-  }
+struct RandomizedSelector {
+  static const char* name() { return "randomized"; }
+  static const char* title() { return "Randomized Routing"; }
+  static const bool kDeterminedByCandidates = false;
 
-  int min_sensor = candidates[0];
-  double min_distance = network.GetDistance(sensor, min_sensor);
-  int second_min_sensor = candidates[1];
-  double second_min_distance = network.GetDistance(sensor, second_min_sensor);
-  if (min_distance > second_min_sensor) {
-    std::swap(min_sensor, second_min_sensor);
-    std::swap(min_distance, second_min_distance);
-  }
-  for (int i = 2; i < candidates.size(); i++) {
-    double distance = network.GetDistance(sensor, candidates[i]);
-    if (distance < min_distance) {
-      second_min_sensor = min_sensor;
-      second_min_distance = min_distance;
-      min_sensor = candidates[i];
-      min_distance = distance;
-    } else if (distance < second_min_distance) {
-      second_min_sensor = candidates[i];
-      second_min_distance = distance;
-    }
+  RandomizedSelector(const SensorNetwork& network, Random* random)
+      : random_(random) {
   }
 
-  return second_min_sensor;
-}
-
-SecondNearestFirstRoutingBuilder::SecondNearestFirstRoutingBuilder()
-    : RoutingBuilder("second-nearest-first",
-                     "Second Nearest First Routing",
-                     new SecondNearestFirstParentSelector()) {
-}
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    return candidates[random_->NextInt(candidates.size())];
+  }
 
-class FarthestFirstParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
+  Random* random_;
 };
 
-int FarthestFirstParentSelector::SelectParent(int sensor,
-                                              const std::vector<int>& candidates,
-                                              const SensorNetwork& network) {
-  assert(!candidates.empty());
-  int parent = candidates[0];
-  double max_distance = network.GetDistance(sensor, parent);
-  for (int i = 1; i < candidates.size(); i++) {
-    double distance = network.GetDistance(sensor, candidates[i]);
-    if (distance > max_distance) {
-      parent = candidates[i];
-      max_distance = distance;
-    }
+// Selects a candidate with a probability in proportion to the reciprocal of
+// its number of neighbors, which changes with channels between sensors of the
+// same level as well.
+struct WeightedRandomizedSelector {
+  static const char* name() { return "weighted-randomized"; }
+  static const char* title() { return "Weighted Randomized Routing"; }
+  static const bool kDeterminedByCandidates = false;
+
+  WeightedRandomizedSelector(const SensorNetwork& network, Random* random)
+      : network_(network), random_(random) {
   }
 
-  return parent;
-}
+  int SelectParent(Span<int> candidates, Span<Scalar> distances) const {
+    assert(!candidates.empty());
+    double total_weights = 0.0;
+    for (int i = 0; i < candidates.size(); i++) {
+      total_weights += GetWeight(candidates[i]);
+    }
 
-FarthestFirstRoutingBuilder::FarthestFirstRoutingBuilder()
-    : RoutingBuilder("farthest-first",
-                     "Farthest First Routing",
-                     new FarthestFirstParentSelector()) {
-}
+    // The weights are computed again rather than kept, which gives the same
+    // values without any memory for them.
+    double r = random_->NextDouble(0, total_weights);
+    for (int i = 0; i < candidates.size(); i++) {
+      const double weight = GetWeight(candidates[i]);
+      if (r < weight) {
+        return candidates[i];
+      }
+      r -= weight;
+    }
 
-class WeightedRandomizedParentSelector : public ParentSelector {
- public:
-  int SelectParent(int sensor,
-                   const std::vector<int>& candidates,
-                   const SensorNetwork& network);
-};
+    // Should never get here.
+    assert(false);
+    exit(1);
+  }
 
-int WeightedRandomizedParentSelector::SelectParent(
-    int sensor,
-    const std::vector<int>& candidates,
-    const SensorNetwork& network) {
-  assert(!candidates.empty());
-  std::vector<double> weights(candidates.size());
-  double total_weights = 0.0;
-  for (int i = 0; i < candidates.size(); i++) {
-    int num_neighbors = network.GetNeighbors(i).size();
+  double GetWeight(int candidate) const {
+    int num_neighbors = network_.GetNeighbors(candidate).size();
     assert(num_neighbors > 0);
-    weights[i] = 1.0 / num_neighbors;
-    total_weights += weights[i];
+    return 1.0 / num_neighbors;
   }
 
-  double r = DoubleRand(0, total_weights);
-  for (int i = 0; i < weights.size(); i++) {
-    if (r < weights[i]) {
-      return candidates[i];
-    }
-    r -= weights[i];
-  }
+  const SensorNetwork& network_;
+  Random* random_;
+};
 
-  // Should never get here.
-  assert(false);
-  exit(1);
+template <typename Selector>
+SelectorRoutingBuilder<Selector>::SelectorRoutingBuilder()
+    : RoutingBuilder(Selector::name(), Selector::title()) {
 }
 
-WeightedRandomizedRoutingBuilder::WeightedRandomizedRoutingBuilder()
-    : RoutingBuilder("weighted-randomized",
-                     "Weighted Randomized Routing",
-                     new WeightedRandomizedParentSelector()) {
+template <typename Selector>
+void SelectorRoutingBuilder<Selector>::BuildRouting(
+    const SensorNetwork& network,
+    Random* random,
+    RoutingTree* tree) const {
+  ScopedTimer timer("routing", name().c_str());
+  assert(network.IsConnected());
+  const ParentCandidates& candidates = network.GetParentCandidates();
+  tree->Reset(network.num_sensors());
+
+  Selector selector(network, random);
+  // Base station does not need to and cannot select parent.
+  for (int i = 1; i < network.num_sensors(); i++) {
+    int parent = selector.SelectParent(candidates.GetCandidates(i),
+                                       candidates.GetCandidateDistances(i));
+    // Every parent is one level closer to the base station, so the tree
+    // connects all sensors without walking it again.
+    assert(candidates.GetLevel(parent) == candidates.GetLevel(i) - 1);
+    tree->SetParent(i, parent);
+  }
 }
 
+template class SelectorRoutingBuilder<EarliestFirstSelector>;
+template class SelectorRoutingBuilder<SecondEarliestFirstSelector>;
+template class SelectorRoutingBuilder<LatestFirstSelector>;
+template class SelectorRoutingBuilder<NearestFirstSelector>;
+template class SelectorRoutingBuilder<SecondNearestFirstSelector>;
+template class SelectorRoutingBuilder<FarthestFirstSelector>;
+template class SelectorRoutingBuilder<RandomizedSelector>;
+template class SelectorRoutingBuilder<WeightedRandomizedSelector>;
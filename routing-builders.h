@@ -7,71 +7,96 @@
 
 #include <string>
 
+#include "random.h"
+#include "routing-tree.h"
 #include "sensor-network.h"
 
-class ParentSelector;
-
 class RoutingBuilder {
  public:
-  // Takes ownership of selector.
-  RoutingBuilder(const std::string& name,
-                 const std::string& title,
-                 ParentSelector* selector)
-    : name_(name), title_(title), selector_(selector) {
+  RoutingBuilder(const std::string& name, const std::string& title)
+    : name_(name), title_(title) {
   }
 
-  virtual ~RoutingBuilder();
+  virtual ~RoutingBuilder() {}
 
   const std::string& name() const { return name_; }
 
   const std::string& title() const { return title_; }
 
-  void BuildRouting(SensorNetwork* network);
+  // Replaces tree with a routing of the network, which must be connected.
+  // Randomized builders draw from the given generator. Builders do not keep
+  // any state and do not change the network, so builders may run on one
+  // network from multiple threads at once.
+  virtual void BuildRouting(const SensorNetwork& network,
+                            Random* random,
+                            RoutingTree* tree) const = 0;
+
+  // Returns whether the routing only depends on the parent candidates of the
+  // network, so that a routing stays valid while they do not change.
+  // Randomized builders draw a new routing from every generator, and may
+  // depend on the rest of the channels as well.
+  virtual bool IsDeterminedByCandidates() const = 0;
 
  private:
   const std::string name_;
   const std::string title_;
-  ParentSelector* selector_;
-};
-
-class EarliestFirstRoutingBuilder : public RoutingBuilder {
- public:
-  EarliestFirstRoutingBuilder();
 };
 
-class SecondEarliestFirstRoutingBuilder : public RoutingBuilder {
+// Builds a BFS routing tree rooted at the base station, in which every sensor
+// selects its parent among its parent candidates, see ParentCandidates.
+//
+// The candidates are computed once per deployment and shared by all builders.
+// The Selector is inlined into the loop over the sensors, so selecting a
+// parent takes no virtual call, and the deterministic selectors pick their
+// parent in one pass over the candidates. The selectors are defined, and the
+// builders instantiated, in routing-builders.cc.
+template <typename Selector>
+class SelectorRoutingBuilder : public RoutingBuilder {
  public:
-  SecondEarliestFirstRoutingBuilder();
-};
+  SelectorRoutingBuilder();
 
-class LatestFirstRoutingBuilder : public RoutingBuilder {
- public:
-  LatestFirstRoutingBuilder();
-};
-
-class NearestFirstRoutingBuilder : public RoutingBuilder {
- public:
-  NearestFirstRoutingBuilder();
-};
+  void BuildRouting(const SensorNetwork& network,
+                    Random* random,
+                    RoutingTree* tree) const;
 
-class SecondNearestFirstRoutingBuilder : public RoutingBuilder {
- public:
-  SecondNearestFirstRoutingBuilder();
-};
-
-class FarthestFirstRoutingBuilder : public RoutingBuilder {
- public:
-  FarthestFirstRoutingBuilder();
-};
-
-class RandomizedRoutingBuilder : public RoutingBuilder {
- public:
-  RandomizedRoutingBuilder();
+  bool IsDeterminedByCandidates() const {
+    return Selector::kDeterminedByCandidates;
+  }
 };
 
-class WeightedRandomizedRoutingBuilder : public RoutingBuilder {
- public:
-  WeightedRandomizedRoutingBuilder();
-};
+struct EarliestFirstSelector;
+struct SecondEarliestFirstSelector;
+struct LatestFirstSelector;
+struct NearestFirstSelector;
+struct SecondNearestFirstSelector;
+struct FarthestFirstSelector;
+struct RandomizedSelector;
+struct WeightedRandomizedSelector;
+
+extern template class SelectorRoutingBuilder<EarliestFirstSelector>;
+extern template class SelectorRoutingBuilder<SecondEarliestFirstSelector>;
+extern template class SelectorRoutingBuilder<LatestFirstSelector>;
+extern template class SelectorRoutingBuilder<NearestFirstSelector>;
+extern template class SelectorRoutingBuilder<SecondNearestFirstSelector>;
+extern template class SelectorRoutingBuilder<FarthestFirstSelector>;
+extern template class SelectorRoutingBuilder<RandomizedSelector>;
+extern template class SelectorRoutingBuilder<WeightedRandomizedSelector>;
+
+typedef SelectorRoutingBuilder<EarliestFirstSelector>
+    EarliestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<SecondEarliestFirstSelector>
+    SecondEarliestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<LatestFirstSelector>
+    LatestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<NearestFirstSelector>
+    NearestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<SecondNearestFirstSelector>
+    SecondNearestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<FarthestFirstSelector>
+    FarthestFirstRoutingBuilder;
+typedef SelectorRoutingBuilder<RandomizedSelector>
+    RandomizedRoutingBuilder;
+typedef SelectorRoutingBuilder<WeightedRandomizedSelector>
+    WeightedRandomizedRoutingBuilder;
 
 #endif  // NETWORKING_ROUTING_BUILDERS_H_
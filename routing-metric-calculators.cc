@@ -12,48 +12,44 @@
 #include <map>
 #include <numeric>
 #include <set>
+#include <utility>
 #include <vector>
 
+#include "events.h"
 #include "position.h"
 #include "region.h"
+#include "sensor-marks.h"
 #include "sensor-network.h"
 
 namespace {
 
-double BitAccuracyRate(double distance,
-                       double communication_range,
-                       double noise) {
-  // Early versions of GCC does not recognize std::erfc().
-  return 1 - 0.5 * erfc(std::sqrt(
-      1.0 / (pow(distance / communication_range, 4) * noise)));
+// Suppose the Bit Error Rate at the communication range is 1e-3, i.e
+// 0.5 * erfc(sqrt(1 / noise)) = 1e-3
+const double kNoise = 0.209434;
+
+// Returns erfc(x) for x >= 0 with a fractional error below 1.2e-7, from the
+// Chebyshev fit in Numerical Recipes. Unlike std::erfc(), it has no branches,
+// so that a loop over it can be vectorized. The fit is evaluated in T, so that
+// a float loop is vectorized twice as wide.
+template <typename T>
+inline T ComplementaryErrorFunction(T x) {
+  const T t = T(1.0) / (T(1.0) + T(0.5) * x);
+  return t * std::exp(-x * x - T(1.26551223) +
+      t * (T(1.00002368) + t * (T(0.37409196) + t * (T(0.09678418) +
+      t * (T(-0.18628806) + t * (T(0.27886807) + t * (T(-1.13520398) +
+      t * (T(1.48851587) + t * (T(-0.82215223) + t * T(0.17087277))))))))));
 }
 
-}  // namespace
-
-double NodeDegreeVarianceCalculator::CalculateMetric(
-    const SensorNetwork& network) {
-  assert(network.num_sensors() > 0);
-  assert(network.IsConnectedWithRoutings());
-
-  std::vector<int> degrees(network.num_sensors());
-  int sum = 0;
-  // Base station (sensor #0) does not have a parent, so we start at sensor #1.
-  for (int i = 1; i < degrees.size(); i++) {
-    int parent = network.GetParent(i);
-    assert(parent >= 0);
-    degrees[parent]++;
-    sum++;
+// Stores the Bit Accuracy Rates of n links into rates, given the lengths of
+// the links relative to the communication range.
+template <typename T>
+void CalculateBitAccuracyRates(int n, const T* ratios, T* rates) {
+  const T scale = T(1.0 / std::sqrt(kNoise));
+  for (int i = 0; i < n; i++) {
+    // sqrt(1 / (ratio^4 * noise))
+    const T x = scale / (ratios[i] * ratios[i]);
+    rates[i] = T(1.0) - T(0.5) * ComplementaryErrorFunction(x);
   }
-
-  double average = sum / degrees.size();
-  double variance = 0.0;
-  for (int i = 0; i < degrees.size(); i++) {
-    int difference = (degrees[i] - average);
-    variance += difference * difference;
-  }
-  variance /= degrees.size();
-
-  return variance;
 }
 
 struct SensorUsage {
@@ -61,197 +57,458 @@ struct SensorUsage {
   int usage;
 };
 
-bool operator>(const SensorUsage& lhs, const SensorUsage& rhs) {
-  return lhs.usage > rhs.usage;
+// Orders sensors by their usage in descending order, and then by their IDs.
+bool operator<(const SensorUsage& lhs, const SensorUsage& rhs) {
+  if (lhs.usage != rhs.usage) {
+    return lhs.usage > rhs.usage;
+  }
+  return lhs.sensor < rhs.sensor;
 }
 
-// Sort sensors by their usage in descending order.
-// NOTE that the base station (sensor #0) will always be the first in
-// sorted_sensors. You may be interested in the second sensor in the list for
-// many purposes.
-void SortSensorsByUsage(const SensorNetwork& network,
-                        std::vector<int>* sorted_sensors) {
-  std::vector<SensorUsage> usages(network.num_sensors());
-  for (int i = 0; i < usages.size(); i++) {
-    usages[i].sensor = i;
-    usages[i].usage = 1;  // Every sensor is used by itself.
+// Fenwick tree of integers over the indices [0, n).
+class FenwickTree {
+ public:
+  FenwickTree() {}
+
+  // Sets all integers of a tree over [0, n) to 0.
+  void Reset(int n) {
+    sums_.assign(n + 1, 0);
   }
 
-  for (int i = 0; i < network.num_sensors(); i++) {
-    int parent = network.GetParent(i);
-    while (parent >= 0) {
-      usages[parent].usage++;
-      parent = network.GetParent(parent);
+  void Add(int index, int delta) {
+    for (int i = index + 1; i < sums_.size(); i += i & -i) {
+      sums_[i] += delta;
     }
   }
 
-  std::sort(usages.begin(), usages.end(), std::greater<SensorUsage>());
+  // Returns the sum of [0, end).
+  int Sum(int end) const {
+    int sum = 0;
+    for (int i = end; i > 0; i -= i & -i) {
+      sum += sums_[i];
+    }
+    return sum;
+  }
 
-  sorted_sensors->resize(usages.size());
-  for (int i = 0; i < usages.size(); i++) {
-    (*sorted_sensors)[i] = usages[i].sensor;
+ private:
+  std::vector<int> sums_;
+};
+
+// Fails the given sensors one after another, and stores the percentage of the
+// remaining sensors still connected to the base station after each failure
+// into values. A failed sensor disconnects its whole subtree, which occupies a
+// contiguous range of preorder indices, so each failure only takes O(log n):
+// one tree marks the subtrees of the failed sensors to tell if a sensor is
+// already disconnected, the other counts the disconnected sensors within a
+// subtree.
+void CalculateRobustnessCurve(const RoutingTreeView& tree,
+                              const std::vector<int>& failures,
+                              FenwickTree* failed_subtrees,
+                              FenwickTree* disconnected_sensors,
+                              double* values) {
+  const int n = tree.num_sensors();
+  failed_subtrees->Reset(n + 1);
+  disconnected_sensors->Reset(n);
+  int num_disconnected = 0;
+  for (int k = 0; k < failures.size(); k++) {
+    int sensor = failures[k];
+    int begin = tree.GetPreorderIndex(sensor);
+    int end = begin + tree.GetSubtreeSize(sensor);
+    if (failed_subtrees->Sum(begin + 1) == 0) {
+      int newly_disconnected = tree.GetSubtreeSize(sensor) -
+          (disconnected_sensors->Sum(end) - disconnected_sensors->Sum(begin));
+      disconnected_sensors->Add(begin, newly_disconnected);
+      num_disconnected += newly_disconnected;
+      failed_subtrees->Add(begin, 1);
+      failed_subtrees->Add(end, -1);
+    }
+    int num_failed = k + 1;
+    values[k] = (n - num_disconnected) * 1.0 / (n - num_failed);
   }
 }
 
-// Assume the most used sensor (except the base station) is failed and removed
-// from the network, what is the percentage of the remaining sensors which are
-// still connected to the base station.
-double RobustnessCalculator::CalculateMetric(const SensorNetwork& network) {
-  if (network.num_sensors() < 3) {
-    return 0.0;
+// Arrays of the latency calculation, reused by all events. Only the entries of
+// the active subtree are set, and the active marks are cleared in O(1) time
+// for every event, so that an event takes time linear in the size of its
+// active subtree.
+class LatencyWorkspace {
+ public:
+  LatencyWorkspace() {}
+
+  // Prepares the arrays for a network with the given number of sensors.
+  void Reset(int num_sensors) {
+    heights_.resize(num_sensors);
+    ready_times_.resize(num_sensors);
   }
 
-  std::vector<int> sorted;
-  SortSensorsByUsage(network, &sorted);
+  // Every sensor forwards its data to its parent one hop per time slot, and a
+  // parent receives from its children one at a time, in the order in which
+  // the children become ready: children of a lower height in the active
+  // subtree first, and then children of lower IDs.
+  //
+  // The active subtree is visited in breadth-first order, and then backwards,
+  // so that every sensor is visited after all of its children.
+  int Calculate(const RoutingTreeView& tree, Span<int> triggered) {
+    active_.Reset(tree.num_sensors());
+    for (int i = 0; i < triggered.size(); i++) {
+      int parent = triggered[i];
+      while (parent >= 0 && !active_.IsMarked(parent)) {
+        active_.Mark(parent);
+        heights_[parent] = 0;
+        parent = tree.GetParent(parent);
+      }
+    }
 
-  // Assume the most frequently used sensors (except the base station) is failed.
-  std::set<int> disconnected;
-  int num_failed = 1;  // TODO: support more than one failed sensors.
-  for (int i = 1; i <= num_failed; i++) {
-    disconnected.insert(sorted[i]);
-  }
+    order_.clear();
+    order_.push_back(0);
+    for (int head = 0; head < order_.size(); head++) {
+      Span<int> children = tree.GetChildren(order_[head]);
+      for (const int* child = children.begin(); child != children.end();
+           ++child) {
+        if (active_.IsMarked(*child)) {
+          order_.push_back(*child);
+        }
+      }
+    }
 
-  std::set<int> connected;
-  connected.insert(0);  // The base station is always connected (with itself).
+    for (int k = order_.size() - 1; k >= 0; k--) {
+      int sensor = order_[k];
+      ready_children_.clear();
+      Span<int> children = tree.GetChildren(sensor);
+      for (const int* child = children.begin(); child != children.end();
+           ++child) {
+        if (active_.IsMarked(*child)) {
+          ready_children_.push_back(std::make_pair(heights_[*child], *child));
+          heights_[sensor] = std::max(heights_[sensor], heights_[*child] + 1);
+        }
+      }
+      std::sort(ready_children_.begin(), ready_children_.end());
 
-  for (int i = 1; i < network.num_sensors(); i++) {
-    std::set<int> parents;
-    int parent = i;
-    while (disconnected.find(parent) == disconnected.end() &&
-           connected.find(parent) == connected.end()) {
-      parents.insert(parent);
-      parent = network.GetParent(parent);
-      assert(parent >= 0);
+      int ready_time = 0;
+      for (int i = 0; i < ready_children_.size(); i++) {
+        ready_time =
+            std::max(ready_time, ready_times_[ready_children_[i].second]) + 1;
+      }
+      ready_times_[sensor] = ready_time;
     }
-    if (disconnected.find(parent) != disconnected.end()) {
-      disconnected.insert(parents.begin(), parents.end());
-    } else {
-      connected.insert(parents.begin(), parents.end());
+
+    return ready_times_[0];
+  }
+
+  // Replaces ready_times with the ready times of the last event, which are 0
+  // outside of its active subtree.
+  void GetReadyTimes(std::vector<int>* ready_times) const {
+    ready_times->assign(heights_.size(), 0);
+    for (int k = 0; k < order_.size(); k++) {
+      (*ready_times)[order_[k]] = ready_times_[order_[k]];
     }
   }
-  return connected.size() * 1.0 / (network.num_sensors() - num_failed);
+
+ private:
+  SensorMarks active_;
+  std::vector<int> heights_;
+  std::vector<int> ready_times_;
+
+  // Active subtree in breadth-first order.
+  std::vector<int> order_;
+
+  // (height, ID) of the active children of a sensor.
+  std::vector<std::pair<int, int> > ready_children_;
+};
+
+}  // namespace
+
+struct MetricWorkspace::Buffers {
+  // Robustness: the sensors by usage, the pool of random failures, and the
+  // sensors to fail.
+  std::vector<SensorUsage> usages;
+  std::vector<int> pool;
+  std::vector<int> failures;
+  std::vector<double> curve;
+  FenwickTree failed_subtrees;
+  FenwickTree disconnected_sensors;
+
+  // Event metrics: the default event, and the sensors it triggers.
+  std::vector<Event> default_events;
+  EventBatch default_batch;
+
+  // Channel quality: relative link lengths and accuracy rates.
+  std::vector<Scalar> ratios;
+  std::vector<Scalar> path_rates;
+  std::vector<Scalar> rates;
+
+  // Data aggregation: the sensors on the paths of the triggered sensors.
+  SensorMarks visited;
+
+  LatencyWorkspace latency;
+};
+
+MetricWorkspace::MetricWorkspace() : buffers_(new Buffers()) {
 }
 
-double ChannelQualityCalculator::CalculateMetric(const SensorNetwork& network) {
-  // Suppose the Bit Error Rate at the communication range is 1e-3, i.e
-  // 0.5 * erfc(sqrt(1 / noise)) = 1e-3
-  static const double noise = 0.209434;
-  static const double sensing_range = 15.0;
+MetricWorkspace::~MetricWorkspace() {
+}
 
-  std::vector<int> triggered;
-  Position position(50.0, 50.0);  // FIXME: pass in region to the calculator.
-  if (!network.FindSensorsWithinRange(position, sensing_range, &triggered)) {
-    // No sensor will ever be triggered by the event.
-    return 0.0;
+double NodeDegreeVarianceCalculator::CalculateMetric(
+    const SensorNetwork& network, const RoutingTreeView& tree) const {
+  assert(network.num_sensors() > 0);
+
+  const int n = network.num_sensors();
+  int sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += tree.GetNumChildren(i);
   }
 
-  // Link Error Rates
-  std::vector<double> lers(triggered.size());
-  for (int i = 0; i < triggered.size(); i++) {
-    int sensor = triggered[i];
-    double distance = Distance(position, network.GetPosition(sensor));
-    // Link Accuracy Rate
-    double lar = BitAccuracyRate(distance, network.communication_range(), noise);
-    int parent = network.GetParent(sensor);
-    while (parent >= 0) {
-      double distance = Distance(network.GetPosition(sensor),
-                                 network.GetPosition(parent));
-      lar *= BitAccuracyRate(distance, network.communication_range(), noise);
-      parent = network.GetParent(parent);
-    }
-    lers[i] = 1.0 - lar;
+  double average = sum / n;
+  double variance = 0.0;
+  for (int i = 0; i < n; i++) {
+    int difference = (tree.GetNumChildren(i) - average);
+    variance += difference * difference;
   }
+  variance /= n;
 
-  return std::accumulate(lers.begin(), lers.end(), 0.0) / lers.size();
+  return variance;
 }
 
-double DataAggregationCalculator::CalculateMetric(const SensorNetwork& network) {
-  // TODO: Make it an argument.
-  static const double sensing_range = 15.0;
-  std::vector<int> triggered;
-  Position position(50.0, 50.0);  // FIXME: pass in region to the calculator.
-  if (!network.FindSensorsWithinRange(position, sensing_range, &triggered)) {
-    // No sensor will ever be triggered by the event.
+double RobustnessCalculator::CalculateMetric(
+    const SensorNetwork& network, const RoutingTreeView& tree) const {
+  if (network.num_sensors() < 3) {
     return 0.0;
   }
 
-  std::set<int> visited;
-  visited.insert(0);
+  // A sensor is used by every sensor in its subtree, and failing it
+  // disconnects exactly its subtree. The base station is always connected
+  // (with itself).
+  int max_usage = 0;
+  for (int i = 1; i < network.num_sensors(); i++) {
+    max_usage = std::max(max_usage, tree.GetSubtreeSize(i));
+  }
 
-  int num_transmissions = 1;
-  for (int i = 0; i < triggered.size(); i++) {
-    visited.insert(triggered[i]);
-    num_transmissions++;
-    int parent = network.GetParent(triggered[i]);
-    while (visited.find(parent) == visited.end()) {
-      visited.insert(parent);
-      num_transmissions++;
-      parent = network.GetParent(parent);
-      assert(parent >= 0);
-    }
+  int num_failed = 1;
+  int num_connected = network.num_sensors() - max_usage;
+  return num_connected * 1.0 / (network.num_sensors() - num_failed);
+}
+
+// Assume the k most used sensors (except the base station) are failed and
+// removed from the network, what is the percentage of the remaining sensors
+// which are still connected to the base station.
+void RobustnessCalculator::CalculateMetrics(const SensorNetwork& network,
+                                            const RoutingTreeView& tree,
+                                            Random* random,
+                                            MetricWorkspace* workspace,
+                                            double* values) const {
+  std::fill(values, values + max_failures_, 0.0);
+  if (network.num_sensors() < 3) {
+    return;
   }
 
-  return num_transmissions;
+  MetricWorkspace::Buffers* buffers = workspace->buffers();
+  std::vector<SensorUsage>& usages = buffers->usages;
+  usages.resize(network.num_sensors() - 1);
+  for (int i = 0; i < usages.size(); i++) {
+    usages[i].sensor = i + 1;
+    usages[i].usage = tree.GetSubtreeSize(i + 1);
+  }
+  int num_failures = std::min<int>(max_failures_, usages.size());
+  std::partial_sort(usages.begin(), usages.begin() + num_failures,
+                    usages.end());
+
+  std::vector<int>& failures = buffers->failures;
+  failures.resize(num_failures);
+  for (int k = 0; k < num_failures; k++) {
+    failures[k] = usages[k].sensor;
+  }
+  CalculateRobustnessCurve(tree, failures, &buffers->failed_subtrees,
+                           &buffers->disconnected_sensors, values);
 }
 
-double LatencyCalculator::CalculateMetric(const SensorNetwork& network) {
-  // TODO: Make sensing_range and position arguments.
-  const double sensing_range = 15.0;
-  const Position position(50.0, 50.0);
+double RandomFailureRobustnessCalculator::CalculateMetric(
+    const SensorNetwork& network, const RoutingTreeView& tree) const {
+  Random random(0);
+  MetricWorkspace workspace;
+  std::vector<double> values(max_failures_);
+  CalculateMetrics(network, tree, &random, &workspace, values.data());
+  return values[0];
+}
 
-  std::vector<int> triggered;
-  if (!network.FindSensorsWithinRange(position, sensing_range, &triggered)) {
-    // No sensor will ever be triggered by the event.
-    return 0.0;
+void RandomFailureRobustnessCalculator::CalculateMetrics(
+    const SensorNetwork& network,
+    const RoutingTreeView& tree,
+    Random* random,
+    MetricWorkspace* workspace,
+    double* values) const {
+  std::fill(values, values + max_failures_, 0.0);
+  if (network.num_sensors() < 3 || num_orderings_ <= 0) {
+    return;
   }
 
-  std::vector<bool> active(network.num_sensors());
-  for (int i = 0; i < triggered.size(); i++) {
-    int parent = triggered[i];
-    while (parent >= 0 && !active[parent]) {
-      active[parent] = true;
-      parent = network.GetParent(parent);
+  // Every ordering shuffles the first num_failures sensors of the pool, which
+  // stays a permutation of all sensors except the base station.
+  MetricWorkspace::Buffers* buffers = workspace->buffers();
+  std::vector<int>& pool = buffers->pool;
+  pool.resize(network.num_sensors() - 1);
+  for (int i = 0; i < pool.size(); i++) {
+    pool[i] = i + 1;
+  }
+  int num_failures = std::min<int>(max_failures_, pool.size());
+  std::vector<int>& failures = buffers->failures;
+  std::vector<double>& curve = buffers->curve;
+  failures.resize(num_failures);
+  curve.resize(num_failures);
+  for (int ordering = 0; ordering < num_orderings_; ordering++) {
+    for (int k = 0; k < num_failures; k++) {
+      std::swap(pool[k], pool[k + random->NextInt(pool.size() - k)]);
+      failures[k] = pool[k];
+    }
+    CalculateRobustnessCurve(tree, failures, &buffers->failed_subtrees,
+                             &buffers->disconnected_sensors, curve.data());
+    for (int k = 0; k < num_failures; k++) {
+      values[k] += curve[k] / num_orderings_;
     }
   }
+}
 
-  std::vector<int> children(network.num_sensors());
-  // Skip the base station which does not have a parent.
-  for (int i = 1; i < network.num_sensors(); i++) {
-    assert(network.GetParent(i) >= 0);
-    if (active[i]) {
-      children[network.GetParent(i)]++;
+double EventMetricCalculator::CalculateMetric(
+    const SensorNetwork& network, const RoutingTreeView& tree) const {
+  MetricWorkspace workspace;
+  double value;
+  CalculateMetrics(network, tree, NULL, &workspace, &value);
+  return value;
+}
+
+void EventMetricCalculator::CalculateMetrics(const SensorNetwork& network,
+                                             const RoutingTreeView& tree,
+                                             Random* random,
+                                             MetricWorkspace* workspace,
+                                             double* values) const {
+  MetricWorkspace::Buffers* buffers = workspace->buffers();
+  buffers->default_events.assign(1, GetDefaultEvent());
+  buffers->default_batch.Build(network, buffers->default_events);
+  CalculateEventMetrics(network, tree, buffers->default_batch, workspace,
+                        values);
+}
+
+// The Link Accuracy Rates of all tree links are calculated in one pass, and
+// multiplied top-down into the accuracy rate of the path from every sensor to
+// the base station, so that every event only needs the rates of the links from
+// the event to the triggered sensors.
+void ChannelQualityCalculator::CalculateEventMetrics(
+    const SensorNetwork& network, const RoutingTreeView& tree,
+    const EventBatch& events, MetricWorkspace* workspace,
+    double* values) const {
+  const int n = network.num_sensors();
+  const Scalar range = network.communication_range();
+  MetricWorkspace::Buffers* buffers = workspace->buffers();
+
+  // Links to the parents, or none for sensors without a parent.
+  std::vector<Scalar>& ratios = buffers->ratios;
+  ratios.resize(n);
+  for (int i = 0; i < n; i++) {
+    int parent = tree.GetParent(i);
+    ratios[i] = parent >= 0 ? network.GetDistance(i, parent) / range : 0.0;
+  }
+  std::vector<Scalar>& path_rates = buffers->path_rates;
+  path_rates.resize(n);
+  CalculateBitAccuracyRates(n, ratios.data(), path_rates.data());
+  const std::vector<int>& order = tree.order();
+  for (int k = 0; k < order.size(); k++) {
+    int parent = tree.GetParent(order[k]);
+    if (parent >= 0) {
+      path_rates[order[k]] *= path_rates[parent];
     }
   }
 
-  std::vector<int> timestamps(network.num_sensors());
-  std::vector<bool> visited(network.num_sensors());
-  int num_to_visit = network.num_sensors();
-  // Ignore the inactive sensors by marking them as visited.
-  for (int i = 0; i < network.num_sensors(); i++) {
-    visited[i] = !active[i];
-    num_to_visit -= visited[i];
+  std::vector<Scalar>& rates = buffers->rates;
+  for (int e = 0; e < events.num_events(); e++) {
+    Span<int> triggered = events.GetTriggeredSensors(e);
+    if (triggered.empty()) {
+      // No sensor will ever be triggered by the event.
+      values[e] = 0.0;
+      continue;
+    }
+
+    const Position& position = events.GetEvent(e).position;
+    ratios.resize(triggered.size());
+    rates.resize(triggered.size());
+    for (int i = 0; i < triggered.size(); i++) {
+      ratios[i] = Distance(position, network.GetPosition(triggered[i])) / range;
+    }
+    CalculateBitAccuracyRates(triggered.size(), ratios.data(), rates.data());
+
+    // Sum of Link Error Rates
+    double sum = 0.0;
+    for (int i = 0; i < triggered.size(); i++) {
+      sum += 1.0 - rates[i] * path_rates[triggered[i]];
+    }
+    values[e] = sum / triggered.size();
   }
-  while (num_to_visit > 0) {
-    std::vector<int> leaves;
-    for (int i = 0; i < network.num_sensors(); i++) {
-      if (!visited[i] && children[i] == 0) {
-        int parent = network.GetParent(i);
-        if (parent >= 0) {
-          assert(active[parent]);
-          timestamps[parent] = std::max(timestamps[parent], timestamps[i]) + 1;
-        }
-        leaves.push_back(i);
-        visited[i] = true;
-        num_to_visit--;
-      }
+}
+
+void DataAggregationCalculator::CalculateEventMetrics(
+    const SensorNetwork& network, const RoutingTreeView& tree,
+    const EventBatch& events, MetricWorkspace* workspace,
+    double* values) const {
+  // Only the sensors on the paths of the triggered sensors are marked, and
+  // the marks are cleared in O(1) time before every event, so that an event
+  // takes time linear in the size of its subtree.
+  SensorMarks& visited = workspace->buffers()->visited;
+
+  for (int e = 0; e < events.num_events(); e++) {
+    Span<int> triggered = events.GetTriggeredSensors(e);
+    if (triggered.empty()) {
+      // No sensor will ever be triggered by the event.
+      values[e] = 0.0;
+      continue;
     }
-    for (int i = 0; i < leaves.size(); i++) {
-      int parent = network.GetParent(leaves[i]);
-      if (parent >= 0) {
-        children[parent]--;
+
+    visited.Reset(network.num_sensors());
+    visited.Mark(0);
+    int num_transmissions = 1;
+    for (int i = 0; i < triggered.size(); i++) {
+      visited.Mark(triggered[i]);
+      num_transmissions++;
+      // The walk ends at the base station at the latest, which has no parent
+      // itself.
+      int parent = tree.GetParent(triggered[i]);
+      while (parent >= 0 && !visited.IsMarked(parent)) {
+        visited.Mark(parent);
+        num_transmissions++;
+        parent = tree.GetParent(parent);
+        assert(parent >= 0);
       }
     }
+    values[e] = num_transmissions;
   }
+}
 
-  return timestamps[0];
+void LatencyCalculator::CalculateEventMetrics(
+    const SensorNetwork& network, const RoutingTreeView& tree,
+    const EventBatch& events, MetricWorkspace* workspace,
+    double* values) const {
+  LatencyWorkspace& latency = workspace->buffers()->latency;
+  latency.Reset(network.num_sensors());
+  for (int e = 0; e < events.num_events(); e++) {
+    Span<int> triggered = events.GetTriggeredSensors(e);
+    if (triggered.empty()) {
+      // No sensor will ever be triggered by the event.
+      values[e] = 0.0;
+      continue;
+    }
+    values[e] = latency.Calculate(tree, triggered);
+  }
+}
+
+int LatencyCalculator::CalculateReadyTimes(
+    const SensorNetwork& network, const RoutingTreeView& tree,
+    Span<int> triggered, std::vector<int>* ready_times) const {
+  assert(ready_times != NULL);
+  if (triggered.empty()) {
+    ready_times->assign(network.num_sensors(), 0);
+    return 0;
+  }
+  LatencyWorkspace workspace;
+  workspace.Reset(network.num_sensors());
+  int latency = workspace.Calculate(tree, triggered);
+  workspace.GetReadyTimes(ready_times);
+  return latency;
 }
@@ -5,10 +5,39 @@
 #ifndef NETWORKING_ROUTING_METRIC_CALCULATORS_H_
 #define NETWORKING_ROUTING_METRIC_CALCULATORS_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "events.h"
+#include "random.h"
+#include "routing-tree-view.h"
 #include "sensor-network.h"
 
+// Scratch memory of the calculators. Every thread keeps its own workspace and
+// passes it to all calculators, which reuse its buffers for every routing
+// instead of allocating their own. Once the buffers have grown to the size of
+// the networks, calculating the metrics allocates no memory.
+class MetricWorkspace {
+ public:
+  MetricWorkspace();
+  ~MetricWorkspace();
+
+  // Buffers of the individual calculators, see routing-metric-calculators.cc.
+  struct Buffers;
+
+  Buffers* buffers() {
+    return buffers_.get();
+  }
+
+ private:
+  std::unique_ptr<Buffers> buffers_;
+};
+
+// Calculators do not keep any state, so one calculator may be used from
+// multiple threads at once. They read the routing tree from the given view,
+// which is built once per routing and shared by all calculators, and keep
+// their scratch memory in the workspace of the calling thread.
 class RoutingMetricCalculator {
  public:
   explicit RoutingMetricCalculator(const std::string& name) : name_(name) {}
@@ -16,7 +45,23 @@ class RoutingMetricCalculator {
 
   const std::string& name() const { return name_; }
 
-  virtual double CalculateMetric(const SensorNetwork& network) = 0;
+  virtual double CalculateMetric(const SensorNetwork& network,
+                                 const RoutingTreeView& tree) const = 0;
+
+  // Returns the number of values of the metric per routing, e.g. one value for
+  // each number of failed sensors.
+  virtual int num_values() const { return 1; }
+
+  // Stores all num_values() values of the metric into values. Randomized
+  // metrics draw from the given generator. By default the only value is the
+  // one returned by CalculateMetric().
+  virtual void CalculateMetrics(const SensorNetwork& network,
+                                const RoutingTreeView& tree,
+                                Random* random,
+                                MetricWorkspace* workspace,
+                                double* values) const {
+    values[0] = CalculateMetric(network, tree);
+  }
 
  private:
   const std::string name_;
@@ -27,35 +72,134 @@ class NodeDegreeVarianceCalculator : public RoutingMetricCalculator {
   NodeDegreeVarianceCalculator()
       : RoutingMetricCalculator("node-degree-variance") {}
 
-  double CalculateMetric(const SensorNetwork& network);
+  double CalculateMetric(const SensorNetwork& network,
+                         const RoutingTreeView& tree) const;
 };
 
+// Percentage of the remaining sensors which are still connected to the base
+// station after k = 1 .. max_failures of the most used sensors fail.
 class RobustnessCalculator : public RoutingMetricCalculator {
  public:
-  RobustnessCalculator() : RoutingMetricCalculator("robustness") {}
+  explicit RobustnessCalculator(int max_failures = 1)
+      : RoutingMetricCalculator("robustness"), max_failures_(max_failures) {}
+
+  // Returns the value after the single most used sensor fails.
+  double CalculateMetric(const SensorNetwork& network,
+                         const RoutingTreeView& tree) const;
+
+  int num_values() const { return max_failures_; }
+
+  void CalculateMetrics(const SensorNetwork& network,
+                        const RoutingTreeView& tree,
+                        Random* random,
+                        MetricWorkspace* workspace,
+                        double* values) const;
 
-  double CalculateMetric(const SensorNetwork& network);
+ private:
+  const int max_failures_;
 };
 
-class ChannelQualityCalculator : public RoutingMetricCalculator {
+// Same as RobustnessCalculator, except that the failed sensors are picked at
+// random, averaged over num_orderings random orders of failures.
+class RandomFailureRobustnessCalculator : public RoutingMetricCalculator {
  public:
-  ChannelQualityCalculator() : RoutingMetricCalculator("channel-quality") {}
+  RandomFailureRobustnessCalculator(int max_failures, int num_orderings)
+      : RoutingMetricCalculator("random-failure-robustness"),
+        max_failures_(max_failures), num_orderings_(num_orderings) {}
+
+  // Returns the value after a single random sensor fails, averaged over the
+  // orders of failures of a fixed stream, as it has no generator to draw
+  // from.
+  double CalculateMetric(const SensorNetwork& network,
+                         const RoutingTreeView& tree) const;
+
+  int num_values() const { return max_failures_; }
 
-  double CalculateMetric(const SensorNetwork& network);
+  void CalculateMetrics(const SensorNetwork& network,
+                        const RoutingTreeView& tree,
+                        Random* random,
+                        MetricWorkspace* workspace,
+                        double* values) const;
+
+ private:
+  const int max_failures_;
+  const int num_orderings_;
 };
 
-class DataAggregationCalculator : public RoutingMetricCalculator {
+// Metrics of how the routing delivers the data of the sensors triggered by an
+// event to the base station. Events which trigger no sensor have a value of
+// 0.
+class EventMetricCalculator : public RoutingMetricCalculator {
  public:
-  DataAggregationCalculator() : RoutingMetricCalculator("data-aggregation") {}
+  explicit EventMetricCalculator(const std::string& name)
+      : RoutingMetricCalculator(name) {}
+
+  // Returns the value for the default event.
+  double CalculateMetric(const SensorNetwork& network,
+                         const RoutingTreeView& tree) const;
+
+  // Stores the value for the default event into values.
+  void CalculateMetrics(const SensorNetwork& network,
+                        const RoutingTreeView& tree,
+                        Random* random,
+                        MetricWorkspace* workspace,
+                        double* values) const;
+
+  // Stores the value for every event of the batch into values.
+  virtual void CalculateEventMetrics(const SensorNetwork& network,
+                                     const RoutingTreeView& tree,
+                                     const EventBatch& events,
+                                     MetricWorkspace* workspace,
+                                     double* values) const = 0;
+};
 
-  double CalculateMetric(const SensorNetwork& network);
+// Average error rate of the data from the triggered sensors, as received by
+// the base station.
+class ChannelQualityCalculator : public EventMetricCalculator {
+ public:
+  ChannelQualityCalculator() : EventMetricCalculator("channel-quality") {}
+
+  void CalculateEventMetrics(const SensorNetwork& network,
+                             const RoutingTreeView& tree,
+                             const EventBatch& events,
+                             MetricWorkspace* workspace,
+                             double* values) const;
 };
 
-class LatencyCalculator : public RoutingMetricCalculator {
+// Number of sensors which transmit data when the data of the triggered sensors
+// is aggregated on the way to the base station.
+class DataAggregationCalculator : public EventMetricCalculator {
  public:
-  LatencyCalculator() : RoutingMetricCalculator("latency") {}
+  DataAggregationCalculator() : EventMetricCalculator("data-aggregation") {}
 
-  double CalculateMetric(const SensorNetwork& network);
+  void CalculateEventMetrics(const SensorNetwork& network,
+                             const RoutingTreeView& tree,
+                             const EventBatch& events,
+                             MetricWorkspace* workspace,
+                             double* values) const;
+};
+
+// Number of time slots until the base station has received the data of all
+// triggered sensors.
+class LatencyCalculator : public EventMetricCalculator {
+ public:
+  LatencyCalculator() : EventMetricCalculator("latency") {}
+
+  void CalculateEventMetrics(const SensorNetwork& network,
+                             const RoutingTreeView& tree,
+                             const EventBatch& events,
+                             MetricWorkspace* workspace,
+                             double* values) const;
+
+  // Stores the time slot in which every sensor has received the data of all
+  // triggered sensors in its subtree into ready_times, or 0 for sensors
+  // without any. Returns the ready time of the base station, i.e. the
+  // latency. Takes time linear in the size of the subtree with triggered
+  // sensors.
+  int CalculateReadyTimes(const SensorNetwork& network,
+                          const RoutingTreeView& tree,
+                          Span<int> triggered,
+                          std::vector<int>* ready_times) const;
 };
 
 #endif  // NETWORKING_ROUTING_METRIC_CALCULATORS_H_
@@ -0,0 +1,72 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "routing-tree-view.h"
+
+#include <cassert>
+
+#include "trace.h"
+
+void RoutingTreeView::Build(const RoutingTree& tree) {
+  ScopedTimer timer("routing", "tree-view");
+  const int n = tree.num_sensors();
+  parents_.resize(n);
+  child_offsets_.assign(n + 1, 0);
+  for (int i = 0; i < n; i++) {
+    parents_[i] = tree.GetParent(i);
+    if (parents_[i] >= 0) {
+      child_offsets_[parents_[i] + 1]++;
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    child_offsets_[i + 1] += child_offsets_[i];
+  }
+
+  children_.resize(child_offsets_[n]);
+  next_.assign(child_offsets_.begin(), child_offsets_.end() - 1);
+  for (int i = 0; i < n; i++) {
+    if (parents_[i] >= 0) {
+      children_[next_[parents_[i]]++] = i;
+    }
+  }
+
+  // Top-down pass: breadth-first order and depths.
+  order_.clear();
+  depths_.resize(n);
+  if (n > 0) {
+    order_.push_back(0);
+    depths_[0] = 0;
+  }
+  for (int head = 0; head < order_.size(); head++) {
+    int sensor = order_[head];
+    for (int k = child_offsets_[sensor]; k < child_offsets_[sensor + 1]; k++) {
+      order_.push_back(children_[k]);
+      depths_[children_[k]] = depths_[sensor] + 1;
+    }
+  }
+  // Every sensor must be routed to the base station.
+  assert(order_.size() == n);
+
+  // Bottom-up pass: subtree sizes.
+  subtree_sizes_.assign(n, 1);
+  for (int k = order_.size() - 1; k > 0; k--) {
+    int sensor = order_[k];
+    subtree_sizes_[parents_[sensor]] += subtree_sizes_[sensor];
+  }
+
+  // Second top-down pass: the subtrees of the children of a sensor are laid
+  // out one after another right after the sensor itself.
+  preorder_indices_.resize(n);
+  if (n > 0) {
+    preorder_indices_[0] = 0;
+  }
+  for (int head = 0; head < order_.size(); head++) {
+    int sensor = order_[head];
+    int next_index = preorder_indices_[sensor] + 1;
+    for (int k = child_offsets_[sensor]; k < child_offsets_[sensor + 1]; k++) {
+      preorder_indices_[children_[k]] = next_index;
+      next_index += subtree_sizes_[children_[k]];
+    }
+  }
+}
@@ -0,0 +1,85 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_ROUTING_TREE_VIEW_H_
+#define NETWORKING_ROUTING_TREE_VIEW_H_
+
+#include <vector>
+
+#include "routing-tree.h"
+#include "span.h"
+
+// Structure of a routing tree, rooted at the base station, computed once so
+// that the routing metrics do not have to walk the parent chains over and over
+// again.
+class RoutingTreeView {
+ public:
+  RoutingTreeView() {}
+
+  // Rebuilds the view from the parents of the tree, which must connect every
+  // sensor to the base station. Takes O(n) time, and reuses the memory of the
+  // previous view.
+  void Build(const RoutingTree& tree);
+
+  int num_sensors() const {
+    return parents_.size();
+  }
+
+  int GetParent(int sensor) const {
+    return parents_[sensor];
+  }
+
+  // Returns the children of the sensor in ascending order of IDs.
+  Span<int> GetChildren(int sensor) const {
+    return Span<int>(children_.data() + child_offsets_[sensor],
+                     children_.data() + child_offsets_[sensor + 1]);
+  }
+
+  int GetNumChildren(int sensor) const {
+    return child_offsets_[sensor + 1] - child_offsets_[sensor];
+  }
+
+  // Returns all sensors in breadth-first order from the base station, so that
+  // every sensor comes after its parent. Walking the order backwards visits
+  // every sensor before its parent.
+  const std::vector<int>& order() const {
+    return order_;
+  }
+
+  // Returns the number of hops from the sensor to the base station.
+  int GetDepth(int sensor) const {
+    return depths_[sensor];
+  }
+
+  // Returns the number of sensors whose routes go through the sensor,
+  // including the sensor itself.
+  int GetSubtreeSize(int sensor) const {
+    return subtree_sizes_[sensor];
+  }
+
+  // Returns the index of the sensor in a depth-first preorder of the tree.
+  // The subtree of sensor s occupies the preorder indices
+  // [GetPreorderIndex(s), GetPreorderIndex(s) + GetSubtreeSize(s)).
+  int GetPreorderIndex(int sensor) const {
+    return preorder_indices_[sensor];
+  }
+
+ private:
+  std::vector<int> parents_;
+
+  // The children of sensor i are in [child_offsets_[i], child_offsets_[i + 1])
+  // of children_.
+  std::vector<int> child_offsets_;
+  std::vector<int> children_;
+
+  std::vector<int> order_;
+  std::vector<int> depths_;
+  std::vector<int> subtree_sizes_;
+  std::vector<int> preorder_indices_;
+
+  // next free slot in the children of every sensor, while building the view.
+  std::vector<int> next_;
+};
+
+#endif  // NETWORKING_ROUTING_TREE_VIEW_H_
@@ -0,0 +1,45 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_ROUTING_TREE_H_
+#define NETWORKING_ROUTING_TREE_H_
+
+#include <vector>
+
+// Routing of a sensor network: the parent of every sensor on its route to
+// the base station.
+//
+// The tree is kept apart from the SensorNetwork, which is not changed by
+// building routings, so that multiple builders may run on one network at
+// once, and the trees of several builders may be kept side by side without
+// copying the network. See RoutingTreeView for the structure derived from the
+// parents.
+class RoutingTree {
+ public:
+  RoutingTree() {}
+
+  // Removes all parents of a network with the given number of sensors,
+  // reusing the memory of the previous tree.
+  void Reset(int num_sensors) {
+    parents_.assign(num_sensors, -1);
+  }
+
+  int num_sensors() const {
+    return parents_.size();
+  }
+
+  // Returns the parent of the sensor, or -1 if none.
+  int GetParent(int sensor) const {
+    return parents_[sensor];
+  }
+
+  void SetParent(int sensor, int parent) {
+    parents_[sensor] = parent;
+  }
+
+ private:
+  std::vector<int> parents_;
+};
+
+#endif  // NETWORKING_ROUTING_TREE_H_
@@ -0,0 +1,30 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "sample-log.h"
+
+#include <cassert>
+
+static_assert(sizeof(RawSample) == 48, "RawSample must not be padded");
+
+RawSampleLog::RawSampleLog() : file_(NULL) {
+}
+
+RawSampleLog::~RawSampleLog() {
+  if (file_ != NULL) {
+    std::fclose(file_);
+  }
+}
+
+bool RawSampleLog::Open(const std::string& filename) {
+  assert(file_ == NULL);
+  file_ = std::fopen(filename.c_str(), "ab");
+  return file_ != NULL;
+}
+
+void RawSampleLog::Append(const RawSample* samples, int num_samples) {
+  assert(file_ != NULL);
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::fwrite(samples, sizeof(RawSample), num_samples, file_);
+}
@@ -0,0 +1,60 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_SAMPLE_LOG_H_
+#define NETWORKING_SAMPLE_LOG_H_
+
+#include <stdint.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+// One metric value of one routing of a simulation cell, as stored in the raw
+// sample log. Records are written as is, in the byte order of the host, and
+// are 48 bytes without padding. The builder and calculator are indices into
+// the lists printed with the simulation options, and value is the index of
+// the value of a calculator with multiple values per routing.
+struct RawSample {
+  uint64_t seed;
+  double communication_range;
+  double metric;
+  int32_t num_sensors;
+  int32_t range_index;
+  int32_t repetition;
+  int32_t builder;
+  int32_t calculator;
+  int32_t value;
+};
+
+// Binary log of all metric values of a run, including the ones left out of
+// the averages, so that the results of a large sweep can be analysed again
+// without rerunning the simulations.
+//
+// The log is only ever appended to, so multiple runs can share one file and
+// be told apart by their seeds. Records of different cells may be written by
+// different threads in any order.
+class RawSampleLog {
+ public:
+  RawSampleLog();
+
+  ~RawSampleLog();
+
+  // Returns whether the file could be opened for appending.
+  bool Open(const std::string& filename);
+
+  bool is_open() const {
+    return file_ != NULL;
+  }
+
+  // Appends the records in one go, so that the records of one call are never
+  // interleaved with the ones of another thread.
+  void Append(const RawSample* samples, int num_samples);
+
+ private:
+  std::mutex mutex_;
+  FILE* file_;
+};
+
+#endif  // NETWORKING_SAMPLE_LOG_H_
@@ -0,0 +1,163 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "sensor-grid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Upper bound of the number of cells per sensor, so that a tiny cell size
+// over a large region does not blow up the cell arrays.
+const int kMaxCellsPerSensor = 4;
+
+}  // namespace
+
+// Orders pairs by distance, breaking ties by the sensor IDs.
+bool operator<(const SensorPair& lhs, const SensorPair& rhs) {
+  if (lhs.distance != rhs.distance) {
+    return lhs.distance < rhs.distance;
+  } else if (lhs.s != rhs.s) {
+    return lhs.s < rhs.s;
+  } else {
+    return lhs.t < rhs.t;
+  }
+}
+
+SensorGrid::SensorGrid()
+    : min_x_(0.0), min_y_(0.0), cell_size_(1.0), num_cols_(0), num_rows_(0) {
+}
+
+void SensorGrid::Clear() {
+  num_cols_ = 0;
+  num_rows_ = 0;
+  cell_starts_.clear();
+  ids_.clear();
+  xs_.clear();
+  ys_.clear();
+}
+
+int SensorGrid::GetColumn(double x) const {
+  double column = std::floor((x - min_x_) / cell_size_);
+  if (column < 0.0) {
+    return 0;
+  } else if (column >= num_cols_) {
+    return num_cols_ - 1;
+  }
+  return int(column);
+}
+
+int SensorGrid::GetRow(double y) const {
+  double row = std::floor((y - min_y_) / cell_size_);
+  if (row < 0.0) {
+    return 0;
+  } else if (row >= num_rows_) {
+    return num_rows_ - 1;
+  }
+  return int(row);
+}
+
+void SensorGrid::Build(const std::vector<Position>& positions,
+                       double cell_size) {
+  Clear();
+  if (positions.empty()) {
+    return;
+  }
+
+  double max_x = positions[0].x;
+  double max_y = positions[0].y;
+  min_x_ = positions[0].x;
+  min_y_ = positions[0].y;
+  for (int i = 1; i < positions.size(); i++) {
+    min_x_ = std::min<double>(min_x_, positions[i].x);
+    min_y_ = std::min<double>(min_y_, positions[i].y);
+    max_x = std::max<double>(max_x, positions[i].x);
+    max_y = std::max<double>(max_y, positions[i].y);
+  }
+
+  cell_size_ = cell_size > 0.0 ? cell_size : std::max(max_x - min_x_,
+                                                      max_y - min_y_);
+  if (cell_size_ <= 0.0) {
+    cell_size_ = 1.0;
+  }
+  const double max_cells =
+      double(kMaxCellsPerSensor) * positions.size() + kMaxCellsPerSensor;
+  while ((std::floor((max_x - min_x_) / cell_size_) + 1) *
+         (std::floor((max_y - min_y_) / cell_size_) + 1) > max_cells) {
+    cell_size_ *= 2;
+  }
+  num_cols_ = int(std::floor((max_x - min_x_) / cell_size_)) + 1;
+  num_rows_ = int(std::floor((max_y - min_y_) / cell_size_)) + 1;
+
+  // Counting sort of the sensors by cell. Sensors are visited in ascending
+  // order of IDs, so the IDs within each cell stay sorted.
+  cells_.resize(positions.size());
+  cell_starts_.assign(num_cols_ * num_rows_ + 1, 0);
+  for (int i = 0; i < positions.size(); i++) {
+    cells_[i] = GetRow(positions[i].y) * num_cols_ + GetColumn(positions[i].x);
+    cell_starts_[cells_[i] + 1]++;
+  }
+  for (int c = 0; c < num_cols_ * num_rows_; c++) {
+    cell_starts_[c + 1] += cell_starts_[c];
+  }
+
+  ids_.resize(positions.size());
+  xs_.resize(positions.size());
+  ys_.resize(positions.size());
+  next_.assign(cell_starts_.begin(), cell_starts_.end() - 1);
+  for (int i = 0; i < positions.size(); i++) {
+    int k = next_[cells_[i]]++;
+    ids_[k] = i;
+    xs_[k] = positions[i].x;
+    ys_[k] = positions[i].y;
+  }
+}
+
+void SensorGrid::FindSensorsWithinRange(const Position& position,
+                                        double range,
+                                        std::vector<int>* sensors) const {
+  assert(sensors != NULL);
+  if (ids_.empty()) {
+    return;
+  }
+
+  const int first = sensors->size();
+  const Scalar max_distance = range;
+  const int min_col = GetColumn(position.x - range);
+  const int max_col = GetColumn(position.x + range);
+  const int min_row = GetRow(position.y - range);
+  const int max_row = GetRow(position.y + range);
+  for (int row = min_row; row <= max_row; row++) {
+    // Cells within a row are adjacent in the arrays, so the whole span of
+    // columns is scanned as one contiguous run.
+    int begin = cell_starts_[row * num_cols_ + min_col];
+    int end = cell_starts_[row * num_cols_ + max_col + 1];
+    for (int k = begin; k < end; k++) {
+      Scalar dx = position.x - xs_[k];
+      Scalar dy = position.y - ys_[k];
+      if (std::sqrt(dx * dx + dy * dy) <= max_distance) {
+        sensors->push_back(ids_[k]);
+      }
+    }
+  }
+
+  if (min_row != max_row || min_col != max_col) {
+    std::sort(sensors->begin() + first, sensors->end());
+  }
+}
+
+void SensorGrid::FindPairsWithinRange(double range,
+                                      std::vector<SensorPair>* pairs) const {
+  assert(pairs != NULL);
+  VisitPairsWithinRange(range, [pairs](int s, int t, Scalar distance) {
+    SensorPair pair;
+    pair.s = s;
+    pair.t = t;
+    pair.distance = distance;
+    pairs->push_back(pair);
+    return true;
+  });
+}
@@ -0,0 +1,130 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_SENSOR_GRID_H_
+#define NETWORKING_SENSOR_GRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "position.h"
+
+// A pair of sensors with s < t, and the distance between them.
+struct SensorPair {
+  int s;
+  int t;
+  Scalar distance;
+};
+
+bool operator<(const SensorPair&, const SensorPair&);
+
+// Uniform grid spatial index over a fixed set of sensor positions.
+//
+// The sensors are bucketed into square cells and stored cell by cell in
+// contiguous arrays, so that a range query only touches the few cells that
+// overlap the query square. With the cell size equal to the query range, a
+// query touches at most the 3x3 cells around the query position.
+class SensorGrid {
+ public:
+  SensorGrid();
+
+  // Rebuilds the index over the given positions, reusing the memory of the
+  // previous index. The index of a position in the vector is used as its
+  // sensor ID.
+  void Build(const std::vector<Position>& positions, double cell_size);
+
+  void Clear();
+
+  int num_sensors() const {
+    return ids_.size();
+  }
+
+  // Appends the IDs of the sensors within range from the given position to
+  // sensors, in ascending order of IDs.
+  void FindSensorsWithinRange(const Position& position,
+                              double range,
+                              std::vector<int>* sensors) const;
+
+  // Appends all pairs of sensors within range from each other to pairs, in no
+  // particular order.
+  void FindPairsWithinRange(double range,
+                            std::vector<SensorPair>* pairs) const;
+
+  // Calls visit(s, t, distance) for every pair of sensors within range from
+  // each other, with s < t, in the same order as FindPairsWithinRange(), until
+  // visit returns false. Returns whether all pairs were visited.
+  template <typename Visitor>
+  bool VisitPairsWithinRange(double range, Visitor visit) const;
+
+ private:
+  int GetColumn(double x) const;
+
+  int GetRow(double y) const;
+
+  double min_x_;
+  double min_y_;
+  double cell_size_;
+  int num_cols_;
+  int num_rows_;
+
+  // Sensors in cell c are stored in [cell_starts_[c], cell_starts_[c + 1]) of
+  // ids_, xs_ and ys_. Cells are numbered row by row.
+  std::vector<int> cell_starts_;
+
+  // sensor ids sorted by cell, and by ID within each cell.
+  std::vector<int> ids_;
+
+  // sensor positions in the same order as ids_.
+  std::vector<Scalar> xs_;
+  std::vector<Scalar> ys_;
+
+  // cell of every sensor, and the next free slot of every cell, while
+  // building the index.
+  std::vector<int> cells_;
+  std::vector<int> next_;
+};
+
+template <typename Visitor>
+bool SensorGrid::VisitPairsWithinRange(double range, Visitor visit) const {
+  // Number of cells on each side of a cell that may hold sensors in range.
+  const int span = std::max(1, int(std::ceil(range / cell_size_)));
+  const Scalar max_distance = range;
+
+  for (int row = 0; row < num_rows_; row++) {
+    for (int col = 0; col < num_cols_; col++) {
+      const int cell = row * num_cols_ + col;
+      for (int k = cell_starts_[cell]; k < cell_starts_[cell + 1]; k++) {
+        // Only look at the rest of this cell and the cells after it, so that
+        // every pair is visited once.
+        for (int other_row = row;
+             other_row <= std::min(row + span, num_rows_ - 1);
+             other_row++) {
+          int begin;
+          if (other_row == row) {
+            begin = k + 1;
+          } else {
+            begin = cell_starts_[other_row * num_cols_ +
+                                 std::max(col - span, 0)];
+          }
+          int end = cell_starts_[other_row * num_cols_ +
+                                 std::min(col + span, num_cols_ - 1) + 1];
+          for (int l = begin; l < end; l++) {
+            Scalar dx = xs_[k] - xs_[l];
+            Scalar dy = ys_[k] - ys_[l];
+            Scalar distance = std::sqrt(dx * dx + dy * dy);
+            if (distance <= max_distance &&
+                !visit(std::min(ids_[k], ids_[l]), std::max(ids_[k], ids_[l]),
+                       distance)) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+#endif  // NETWORKING_SENSOR_GRID_H_
@@ -0,0 +1,47 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_SENSOR_MARKS_H_
+#define NETWORKING_SENSOR_MARKS_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+// Marks on the sensors of a network, e.g. the visited sensors of a traversal.
+//
+// A sensor is marked if its stamp equals the current epoch, so Reset() clears
+// all marks in O(1) time by starting a new epoch, instead of touching every
+// sensor. The stamps are only rewritten when the epoch wraps around.
+class SensorMarks {
+ public:
+  SensorMarks() : epoch_(0) {}
+
+  // Clears the marks of all sensors of a network with the given number of
+  // sensors. The memory only grows, so it is reused by smaller networks.
+  void Reset(int num_sensors) {
+    if (stamps_.size() < num_sensors) {
+      stamps_.resize(num_sensors, 0);
+    }
+    if (++epoch_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+
+  bool IsMarked(int sensor) const {
+    return stamps_[sensor] == epoch_;
+  }
+
+  void Mark(int sensor) {
+    stamps_[sensor] = epoch_;
+  }
+
+ private:
+  std::vector<uint32_t> stamps_;
+  uint32_t epoch_;
+};
+
+#endif  // NETWORKING_SENSOR_MARKS_H_
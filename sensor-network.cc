@@ -17,22 +17,55 @@
 #include <queue>
 #include <set>
 
+#include "disjoint-sets.h"
+#include "sensor-grid.h"
+#include "trace.h"
 #include "svg-printer.h"
 #include "utils.h"
 
 namespace {
 
-void CalculateDistances(const std::vector<Position>& positions,
-                        std::vector<std::vector<double> >* distances) {
-  distances->clear();
-  distances->resize(positions.size());
-  for (int i = 0; i < distances->size(); i++) {
-    (*distances)[i].resize(positions.size());
+// Networks with more sensors than this do not keep a distance matrix, which
+// would take O(n^2) memory.
+const int kMaxSensorsForDistanceMatrix = 512;
+
+// Networks with at most this many sensors keep their channels as bit rows too,
+// if every sensor is expected to neighbor at least kMinDenseFraction of all
+// sensors. A row of bits then takes at most 1 / (32 * kMinDenseFraction) the
+// words of a list of neighbors, and the bits of 4096 sensors take 2 MB.
+const int kMaxSensorsForNeighborBits = 4096;
+const double kMinDenseFraction = 1.0 / 32;
+
+// Returns whether the sensors are dense enough at the communication range to
+// keep the channels as bit rows, guessing the number of neighbors from the
+// area of the bounding box of the sensors.
+bool IsDense(const std::vector<Position>& positions,
+             double communication_range) {
+  if (positions.empty() || positions.size() > kMaxSensorsForNeighborBits) {
+    return false;
+  }
+  double min_x = positions[0].x;
+  double min_y = positions[0].y;
+  double max_x = positions[0].x;
+  double max_y = positions[0].y;
+  for (int i = 1; i < positions.size(); i++) {
+    min_x = std::min<double>(min_x, positions[i].x);
+    min_y = std::min<double>(min_y, positions[i].y);
+    max_x = std::max<double>(max_x, positions[i].x);
+    max_y = std::max<double>(max_y, positions[i].y);
   }
+  const double area = (max_x - min_x) * (max_y - min_y);
+  return M_PI * communication_range * communication_range >=
+         kMinDenseFraction * area;
+}
 
-  for (int i = 0; i < positions.size(); i++) {
-    for (int j = i + 1; j < positions.size(); j++) {
-      (*distances)[i][j] = (*distances)[j][i] =
+void CalculateDistances(const std::vector<Position>& positions,
+                        std::vector<Scalar>* distances) {
+  const int n = positions.size();
+  distances->assign(n * n, 0.0);
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      (*distances)[i * n + j] = (*distances)[j * n + i] =
           Distance(positions[i], positions[j]);
     }
   }
@@ -40,45 +73,16 @@ void CalculateDistances(const std::vector<Position>& positions,
 
 }  // namespace
 
-void SensorNetwork::AddSensor(const Position& p) {
-  x_map_.insert(std::pair<double, int>(p.x, sensors_.size()));
-  y_map_.insert(std::pair<double, int>(p.y, sensors_.size()));
-  sensors_.push_back(Sensor(p));
-}
-
 void SensorNetwork::RemoveChannels() {
-  for (int i = 0; i < sensors_.size(); i++) {
-    sensors_[i].RemoveNeighbors();
-  }
-}
-
-void SensorNetwork::FindNeighborCandidates(const Position& position,
-                                           double range,
-                                           std::vector<int>* candidates) const {
-  assert(candidates != NULL);
-  candidates->clear();
-
-  std::set<int> x_neighbors;
-  {
-    SensorMap::const_iterator lower = x_map_.lower_bound(position.x - range);
-    SensorMap::const_iterator upper = x_map_.upper_bound(position.x + range);
-    for (SensorMap::const_iterator it = lower; it != upper; ++it) {
-      x_neighbors.insert(it->second);
-    }
-  }
-
-  std::set<int> y_neighbors;
-  {
-    SensorMap::const_iterator lower = y_map_.lower_bound(position.y - range);
-    SensorMap::const_iterator upper = y_map_.upper_bound(position.y + range);
-    for (SensorMap::const_iterator it = lower; it != upper; ++it) {
-      y_neighbors.insert(it->second);
-    }
-  }
-
-  std::set_intersection(x_neighbors.begin(), x_neighbors.end(),
-                        y_neighbors.begin(), y_neighbors.end(),
-                        std::back_inserter(*candidates));
+  neighbor_offsets_.assign(num_sensors() + 1, 0);
+  neighbor_ends_.assign(num_sensors(), 0);
+  neighbors_.clear();
+  num_channels_ = 0;
+  pairs_.clear();
+  next_pair_ = 0;
+  components_.Reset(num_sensors());
+  has_neighbor_bits_ = false;
+  has_parent_candidates_ = false;
 }
 
 bool SensorNetwork::FindSensorsWithinRange(const Position& position,
@@ -86,176 +90,292 @@ bool SensorNetwork::FindSensorsWithinRange(const Position& position,
                                            std::vector<int>* neighbors) const {
   assert(neighbors != NULL);
   neighbors->clear();
-
-  std::vector<int> candidates;
-  FindNeighborCandidates(position, range, &candidates);
-
-  for (int i = 0; i < candidates.size(); i++) {
-    int c = candidates[i];
-    if (Distance(position, sensors_[c].position()) <= range) {
-      neighbors->push_back(c);
-    }
-  }
-
+  grid_.FindSensorsWithinRange(position, range, neighbors);
   return !neighbors->empty();
 }
 
 bool SensorNetwork::FindSensorsWithinRange(int sensor,
                                            double range,
                                            std::vector<int>* neighbors) const {
-  assert(neighbors != NULL);
-  neighbors->clear();
-
-  std::vector<int> candidates;
-  FindNeighborCandidates(sensors_[sensor].position(), range, &candidates);
-
-  for (int i = 0; i < candidates.size(); i++) {
-    int c = candidates[i];
-    if (distances_[sensor][c] <= range) {
-      neighbors->push_back(c);
-    }
-  }
-
-  return !neighbors->empty();
+  return FindSensorsWithinRange(positions_[sensor], range, neighbors);
 }
 
 void SensorNetwork::CreateChannels(double communication_range) {
+  ScopedTimer timer("network", "create-channels");
   RemoveChannels();
 
   communication_range_ = communication_range;
-  for (int i = 0; i < sensors_.size(); i++) {
-    Sensor& sensor = sensors_[i];
-    const Position& p = sensor.position();
-
-    std::vector<int> neighbors;
-    FindSensorsWithinRange(i, communication_range, &neighbors);
-    for (int j = 0; j < neighbors.size(); j++) {
-      if (neighbors[j] != i) {
-        sensor.AddNeighbor(neighbors[j]);
+  if (IsDense(positions_, communication_range)) {
+    // Every pair within range is found once, and the rows come out of the
+    // bits in ascending order of IDs.
+    neighbor_bits_.Reset(num_sensors());
+    has_neighbor_bits_ = true;
+    grid_.VisitPairsWithinRange(
+        communication_range, [this](int s, int t, Scalar distance) {
+          neighbor_bits_.Set(s, t);
+          neighbor_bits_.Set(t, s);
+          ConnectComponents(s, t);
+          return true;
+        });
+    const int num_words = neighbor_bits_.words_per_row();
+    for (int i = 0; i < num_sensors(); i++) {
+      const uint64_t* row = neighbor_bits_.GetRow(i);
+      int degree = 0;
+      for (int w = 0; w < num_words; w++) {
+        degree += CountBits(row[w]);
       }
+      neighbor_offsets_[i + 1] = neighbor_offsets_[i] + degree;
+    }
+    neighbors_.resize(neighbor_offsets_.back());
+    CopyNeighborBitsToRows();
+  } else {
+    for (int i = 0; i < num_sensors(); i++) {
+      // The sensors within range are appended right into the row of the
+      // sensor, which then drops the sensor itself.
+      const int begin = neighbors_.size();
+      grid_.FindSensorsWithinRange(positions_[i], communication_range,
+                                   &neighbors_);
+      neighbors_.erase(std::remove(neighbors_.begin() + begin,
+                                   neighbors_.end(), i),
+                       neighbors_.end());
+      for (int k = begin; k < neighbors_.size(); k++) {
+        // Every channel is emitted from both ends, so only one of them merges
+        // the components.
+        if (neighbors_[k] > i) {
+          ConnectComponents(i, neighbors_[k]);
+        }
+      }
+      neighbor_offsets_[i + 1] = neighbor_ends_[i] = neighbors_.size();
     }
   }
+  num_channels_ = neighbors_.size() / 2;
+  has_parent_candidates_ = false;
+  TraceCounter("channels", num_channels_);
+  TraceCounter("components", num_components());
 }
 
 void SensorNetwork::AddSensors(const std::vector<Position>& positions) {
   RemoveSensors();
-  for (int i = 0; i < positions.size(); i++) {
-    AddSensor(positions[i]);
-  }
+  positions_ = positions;
 
-  CalculateDistances(positions, &distances_);
+  if (positions.size() <= kMaxSensorsForDistanceMatrix) {
+    CalculateDistances(positions, &distances_);
+  }
 }
 
 void SensorNetwork::RemoveSensors() {
-  sensors_.clear();
-  x_map_.clear();
-  y_map_.clear();
+  positions_.clear();
+  distances_.clear();
+  neighbor_offsets_.clear();
+  neighbor_ends_.clear();
+  neighbors_.clear();
+  num_channels_ = 0;
+  pairs_.clear();
+  next_pair_ = 0;
+  has_neighbor_bits_ = false;
+  has_parent_candidates_ = false;
+  grid_.Clear();
 }
 
 bool SensorNetwork::DeploySensors(const std::vector<Position>& positions,
                                   double communication_range) {
+  ScopedTimer timer("network", "deploy");
   AddSensors(positions);
+  // Index the sensors with cells as large as the communication range, so
+  // that finding the neighbors of a sensor only scans the 3x3 cells around it.
+  grid_.Build(positions, communication_range);
   CreateChannels(communication_range);
-  return IsConnectedWithChannels();
+  if (!IsConnected()) {
+    return false;
+  }
+  has_parent_candidates_ = true;
+  parent_candidates_.Build(*this);
+  return true;
 }
 
-void SensorNetwork::RemoveParents() {
-  for (int i = 0; i < sensors_.size(); i++) {
-    sensors_[i].clear_parent();
+bool SensorNetwork::DeploySensors(const std::vector<Position>& positions,
+                                  double communication_range,
+                                  double max_communication_range) {
+  assert(communication_range <= max_communication_range);
+  ScopedTimer timer("network", "deploy-sweep");
+  AddSensors(positions);
+  grid_.Build(positions, communication_range);
+  RemoveChannels();
+
+  {
+    ScopedTimer timer("network", "find-pairs");
+    grid_.FindPairsWithinRange(max_communication_range, &pairs_);
+    std::sort(pairs_.begin(), pairs_.end());
+  }
+  TraceCounter("sweep-pairs", pairs_.size());
+  for (int i = 0; i < pairs_.size(); i++) {
+    neighbor_offsets_[pairs_[i].s + 1]++;
+    neighbor_offsets_[pairs_[i].t + 1]++;
+  }
+  for (int i = 0; i < num_sensors(); i++) {
+    neighbor_offsets_[i + 1] += neighbor_offsets_[i];
+    neighbor_ends_[i] = neighbor_offsets_[i];
   }
+  neighbors_.resize(neighbor_offsets_.back());
+  if (IsDense(positions, max_communication_range)) {
+    neighbor_bits_.Reset(num_sensors());
+    has_neighbor_bits_ = true;
+  }
+
+  communication_range_ = communication_range;
+  ExtendCommunicationRange(communication_range);
+  if (!IsConnected()) {
+    return false;
+  }
+  // A single sensor has no channel to add, so the parent candidates are not
+  // built while extending the range.
+  if (!has_parent_candidates_) {
+    has_parent_candidates_ = true;
+    parent_candidates_.Build(*this);
+  }
+  return true;
 }
 
-bool SensorNetwork::IsConnectedWithChannels() const {
-  assert(num_sensors() > 0);
-
-  std::vector<bool> visited(num_sensors());
-  int num_visited = 0;
-
-  std::queue<int> queue;
-  queue.push(0);  // Start from the base station.
-  while (!queue.empty()) {
-    int current = queue.front();
-    queue.pop();
-    const std::set<int>& neighbors = GetNeighbors(current);
-    for (std::set<int>::const_iterator neighbor = neighbors.begin();
-         neighbor != neighbors.end();
-         ++neighbor) {
-      if (!visited[*neighbor]) {
-        queue.push(*neighbor);
-        visited[*neighbor] = true;
-        num_visited++;
+void SensorNetwork::AddChannel(int sensor, int neighbor) {
+  assert(neighbor_ends_[sensor] < neighbor_offsets_[sensor + 1]);
+  // Shift the neighbors with greater IDs to make room, which keeps the row
+  // sorted.
+  int k = neighbor_ends_[sensor]++;
+  while (k > neighbor_offsets_[sensor] && neighbors_[k - 1] > neighbor) {
+    neighbors_[k] = neighbors_[k - 1];
+    k--;
+  }
+  neighbors_[k] = neighbor;
+}
+
+void SensorNetwork::CopyNeighborBitsToRows() {
+  const int num_words = neighbor_bits_.words_per_row();
+  for (int i = 0; i < num_sensors(); i++) {
+    const uint64_t* row = neighbor_bits_.GetRow(i);
+    int k = neighbor_offsets_[i];
+    for (int w = 0; w < num_words; w++) {
+      for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+        neighbors_[k++] = w * 64 + GetLowestBit(bits);
       }
     }
+    neighbor_ends_[i] = k;
   }
-
-  return num_visited == num_sensors();
 }
 
-// Checks if the sensor network is fully connected with routings.
-// It is done by checking if the base station can be reached from every sensor.
-bool SensorNetwork::IsConnectedWithRoutings() const {
-  assert(num_sensors() > 0);
-
-  std::vector<bool> visited(num_sensors());
-  int num_connected = 0;
-
-  visited[0] = true;
-  num_connected++;
+bool SensorNetwork::ExtendCommunicationRange(double communication_range) {
+  assert(communication_range >= communication_range_);
+  ScopedTimer timer("network", "extend-range");
+  communication_range_ = communication_range;
 
-  for (int i = 1; i < num_sensors(); i++) {
-    int parent = GetParent(i);
-    while (parent > 0 && !visited[parent]) {
-      visited[parent] = true;
-      parent = GetParent(parent);
+  const int first_pair = next_pair_;
+  bool changed = false;
+  while (next_pair_ < pairs_.size() &&
+         pairs_[next_pair_].distance <= communication_range) {
+    const SensorPair& pair = pairs_[next_pair_++];
+    if (has_neighbor_bits_) {
+      neighbor_bits_.Set(pair.s, pair.t);
+      neighbor_bits_.Set(pair.t, pair.s);
+    } else {
+      AddChannel(pair.s, pair.t);
+      AddChannel(pair.t, pair.s);
     }
-    if (parent < 0) {
-      return false;
+    ConnectComponents(pair.s, pair.t);
+    num_channels_++;
+    if (!has_parent_candidates_ ||
+        parent_candidates_.GetLevel(pair.s) !=
+            parent_candidates_.GetLevel(pair.t)) {
+      changed = true;
     }
-    num_connected++;
   }
-
-  return num_connected == num_sensors();
+  TraceCounter("channels-added", next_pair_ - first_pair);
+  if (has_neighbor_bits_ && next_pair_ > first_pair) {
+    CopyNeighborBitsToRows();
+  }
+  if (changed && IsConnected()) {
+    parent_candidates_.Build(*this);
+    has_parent_candidates_ = true;
+  }
+  return changed;
 }
 
+// The minimum communication range is the longest edge of the Euclidean
+// minimum spanning tree. Only pairs within a guessed range are considered:
+// if they connect all sensors, Kruskal's algorithm over them finds the exact
+// bottleneck edge; otherwise the guess is doubled and the search repeated.
+// For evenly spread sensors the first guess has O(n log n) pairs.
 double CalculateMinimumCommunicationRange(
-    const std::vector<Position>& positions) {
+    const std::vector<Position>& positions,
+    MinimumRangeWorkspace* workspace) {
+  if (workspace == NULL) {
+    MinimumRangeWorkspace local_workspace;
+    return CalculateMinimumCommunicationRange(positions, &local_workspace);
+  }
   if (positions.size() <= 1) {
     return 0.0;
   }
+  ScopedTimer timer("placement", "minimum-range");
 
-  // Matrix of distances between sensors.
-  std::vector<std::vector<double> > distances;
-  CalculateDistances(positions, &distances);
-
-  double min_range = 0.0;
-
-  std::set<int> connected;
-  connected.insert(0);
-
-  std::set<int> unconnected;
+  double min_x = positions[0].x;
+  double min_y = positions[0].y;
+  double max_x = positions[0].x;
+  double max_y = positions[0].y;
   for (int i = 1; i < positions.size(); i++) {
-    unconnected.insert(i);
+    min_x = std::min<double>(min_x, positions[i].x);
+    min_y = std::min<double>(min_y, positions[i].y);
+    max_x = std::max<double>(max_x, positions[i].x);
+    max_y = std::max<double>(max_y, positions[i].y);
+  }
+  const double width = std::max(max_x - min_x, max_y - min_y);
+  if (width <= 0.0) {
+    return 0.0;
   }
 
-  for (int i = 1; i < positions.size(); i++) {
-    int nearest = -1;
-    double min_distance = DBL_MAX;
-    for (std::set<int>::const_iterator c = connected.begin();
-         c != connected.end(); ++c) {
-      for (std::set<int>::const_iterator u = unconnected.begin();
-           u != unconnected.end(); ++u) {
-        if (distances[*c][*u] < min_distance) {
-          min_distance = distances[*c][*u];
-          nearest = *u;
-        }
+  // Random sensors are connected with high probability once every sensor
+  // expects about log(n) neighbors.
+  const int n = positions.size();
+  double range = std::min(width * std::sqrt(std::log(double(n)) / n), width);
+
+  SensorGrid& grid = workspace->grid;
+  DisjointSets& components = workspace->components;
+  std::vector<SensorPair>& pairs = workspace->pairs;
+  while (true) {
+    grid.Build(positions, range);
+    pairs.clear();
+    grid.FindPairsWithinRange(range, &pairs);
+    std::sort(pairs.begin(), pairs.end());
+
+    components.Reset(n);
+    for (int i = 0; i < pairs.size(); i++) {
+      if (components.Union(pairs[i].s, pairs[i].t) &&
+          components.num_sets() == 1) {
+        TraceCounter("minimum-range-pairs", i + 1);
+        return pairs[i].distance;
       }
     }
-    assert(nearest > 0);
-    unconnected.erase(nearest);
-    connected.insert(nearest);
-    min_range = std::max(min_range, min_distance);
+    range *= 2;
   }
-
-  return min_range;
 }
 
+bool CanBeConnected(const std::vector<Position>& positions,
+                    double communication_range,
+                    MinimumRangeWorkspace* workspace) {
+  if (workspace == NULL) {
+    MinimumRangeWorkspace local_workspace;
+    return CanBeConnected(positions, communication_range, &local_workspace);
+  }
+  ScopedTimer timer("placement", "connectivity");
+
+  DisjointSets& components = workspace->components;
+  components.Reset(positions.size());
+  if (positions.size() <= 1) {
+    return true;
+  }
+  // Unlike the minimum range, the pairs need not be sorted, so they are
+  // merged right as the grid finds them.
+  workspace->grid.Build(positions, communication_range);
+  workspace->grid.VisitPairsWithinRange(
+      communication_range, [&components](int s, int t, Scalar distance) {
+        return !components.Union(s, t) || components.num_sets() > 1;
+      });
+  return components.num_sets() == 1;
+}
@@ -5,45 +5,123 @@
 #ifndef NETWORKING_SENSOR_NETWORK_H_
 #define NETWORKING_SENSOR_NETWORK_H_
 
-#include <map>
-#include <set>
+#include <cassert>
 #include <vector>
 
+#include "bit-matrix.h"
+#include "disjoint-sets.h"
+#include "parent-candidates.h"
 #include "position.h"
 #include "region.h"
-#include "sensor.h"
-
+#include "sensor-grid.h"
+#include "span.h"
+
+// Sensors deployed at fixed positions, and the communication channels among
+// them.
+//
+// A deployed network is not changed by building routings or calculating
+// metrics, see RoutingTree, so it may be shared by multiple threads at once.
+// Deploying sensors again reuses the memory of the previous deployment, so a
+// network kept across simulations stops allocating once it has grown to the
+// size of the largest one.
 class SensorNetwork {
  public:
-  SensorNetwork() : communication_range_(0.0) {}
+  SensorNetwork()
+      : num_channels_(0),
+        has_neighbor_bits_(false),
+        next_pair_(0),
+        has_parent_candidates_(false),
+        communication_range_(0.0) {}
 
   int num_sensors() const {
-    return sensors_.size();
+    return positions_.size();
   }
 
-  const std::vector<Sensor>& sensors() const {
-    return sensors_;
+  const std::vector<Position>& positions() const {
+    return positions_;
   }
 
   const Position& GetPosition(int sensor) const {
-    return sensors_[sensor].position();
+    return positions_[sensor];
+  }
+
+  // Returns the spatial index of all sensors.
+  const SensorGrid& grid() const {
+    return grid_;
+  }
+
+  // Returns the neighbors of the sensor in ascending order of IDs.
+  Span<int> GetNeighbors(int sensor) const {
+    return Span<int>(neighbors_.data() + neighbor_offsets_[sensor],
+                     neighbors_.data() + neighbor_ends_[sensor]);
+  }
+
+  // Returns whether the channels are kept as bit rows as well, which is the
+  // case for small networks where every sensor neighbors a large fraction of
+  // all sensors. Going over the bits of a row then takes fewer steps than
+  // going over the list of neighbors.
+  bool has_neighbor_bits() const {
+    return has_neighbor_bits_;
+  }
+
+  // Returns the channels as bit rows, if has_neighbor_bits(): bit j of row i
+  // is set if sensors i and j are neighbors.
+  const BitMatrix& neighbor_bits() const {
+    assert(has_neighbor_bits_);
+    return neighbor_bits_;
   }
 
-  const std::set<int>& GetNeighbors(int sensor) const {
-    return sensors_[sensor].neighbors();
+  // Returns the number of channels, each of which connects two sensors.
+  int num_channels() const {
+    return num_channels_;
   }
 
   double communication_range() const {
     return communication_range_;
   }
 
-  // Checks if the sensor network is fully connected with routings.
-  bool IsConnectedWithRoutings() const;
+  // Returns the number of connected components of the sensors, which is
+  // maintained as the channels are created, without another pass over them.
+  int num_components() const {
+    return components_.num_sets();
+  }
+
+  bool IsConnected() const {
+    return num_components() <= 1;
+  }
+
+  // Replaces sensors with the sensors which are not connected to the base
+  // station.
+  void FindDisconnectedSensors(std::vector<int>* sensors) {
+    components_.FindElementsOutsideSet(0, sensors);
+  }
 
-  // Returns whether the sensors are fully connected with channels.
+  // Returns whether the sensors are fully connected with channels. The parent
+  // candidates are only computed if they are.
   bool DeploySensors(const std::vector<Position>& positions,
                      double communication_range);
 
+  // Same as DeploySensors(), but prepares for a sweep over increasing
+  // communication ranges up to max_communication_range with
+  // ExtendCommunicationRange(). The pairs of sensors within the maximum range
+  // are found and sorted by distance once, and the rows of the channels
+  // reserve room for all of them.
+  bool DeploySensors(const std::vector<Position>& positions,
+                     double communication_range,
+                     double max_communication_range);
+
+  // Raises the communication range up to the maximum one of the deployment,
+  // adding the channels of the sensors within the new range while keeping
+  // the neighbors of every sensor in ascending order of IDs. Takes time
+  // linear in the number of new channels and the lengths of their rows.
+  //
+  // Returns whether any new channel may change the parent candidates, i.e.
+  // whether it connects two sensors of different BFS levels, or the levels
+  // are not known. Channels within a level change neither the levels nor the
+  // parent candidates of any sensor, so the parent candidates are only
+  // computed again for the other ones, once the sensors are connected.
+  bool ExtendCommunicationRange(double communication_range);
+
   // Returns whether there are sensors within range from the given position.
   bool FindSensorsWithinRange(const Position& position,
                               double range,
@@ -54,31 +132,24 @@ class SensorNetwork {
                               double range,
                               std::vector<int>* neighbors) const;
 
-  int GetLevel(int sensor) const {
-    return sensors_[sensor].level();
+  // Returns the BFS levels and parent candidates of all sensors, which are
+  // computed once whenever the channels change, and shared by all routing
+  // builders. The sensors must be connected.
+  const ParentCandidates& GetParentCandidates() const {
+    assert(has_parent_candidates_);
+    return parent_candidates_;
   }
 
-  void SetLevel(int sensor, int level) {
-    sensors_[sensor].set_level(level);
-  }
-
-  int GetParent(int sensor) const {
-    return sensors_[sensor].parent();
-  }
-
-  void SetParent(int sensor, int parent) {
-    sensors_[sensor].set_parent(parent);
-  }
-
-  void RemoveParents();
-
-  double GetDistance(int s, int t) const {
-    return distances_[s][t];
+  // Looks up the distance matrix for small networks, and computes the
+  // distance from the positions otherwise.
+  Scalar GetDistance(int s, int t) const {
+    if (!distances_.empty()) {
+      return distances_[s * positions_.size() + t];
+    }
+    return Distance(positions_[s], positions_[t]);
   }
 
  private:
-  void AddSensor(const Position& p);
-
   void AddSensors(const std::vector<Position>& positions);
 
   void RemoveSensors();
@@ -91,32 +162,94 @@ class SensorNetwork {
   // Removes all communication channels among sensors in the network.
   void RemoveChannels();
 
-  // Checks if the sensor network is fully connected with communication channels.
-  bool IsConnectedWithChannels() const;
+  // Adds the neighbor to the row of the sensor, which must have room for it.
+  void AddChannel(int sensor, int neighbor);
 
-  // Find sensors located within the (2 * range) by (2 * range) square area
-  // centered by the given position.
-  void FindNeighborCandidates(const Position& position,
-                              double range,
-                              std::vector<int>* candidates) const;
-
-  typedef std::multimap<double, int> SensorMap;
-
-  // all sensors with their index in the vector as their IDs.
-  std::vector<Sensor> sensors_;
-
-  // sensor ids sorted by their x position.
-  SensorMap x_map_;
+  // Rewrites the rows of the channels from the neighbor bits. The rows must
+  // have room for them.
+  void CopyNeighborBitsToRows();
 
-  // sensor ids sorted by their y position.
-  SensorMap y_map_;
+  // Merges the components of the sensors of a new channel.
+  void ConnectComponents(int s, int t) {
+    // Once all sensors are connected, no channel can merge components.
+    if (components_.num_sets() > 1) {
+      components_.Union(s, t);
+    }
+  }
 
-  // distance matrix for all sensors.
-  std::vector<std::vector<double> > distances_;
+  // Sensors are identified by their indices in the following vectors.
+
+  // positions of all sensors.
+  std::vector<Position> positions_;
+
+  // Communication channels in compressed sparse row form: the neighbors of
+  // sensor i are stored in [neighbor_offsets_[i], neighbor_ends_[i]) of
+  // neighbors_. The rest of the row, up to neighbor_offsets_[i + 1], is room
+  // for the channels added by ExtendCommunicationRange(). The distances of the
+  // channels are not stored, as only the few to the parent candidates are
+  // needed, see GetDistance().
+  std::vector<int> neighbor_offsets_;
+  std::vector<int> neighbor_ends_;
+  std::vector<int> neighbors_;
+  int num_channels_;
+
+  // the same channels as bit rows, valid if has_neighbor_bits_. Channels are
+  // created in the bits first and copied to the rows, which saves sorting the
+  // rows and shifting them to insert channels.
+  BitMatrix neighbor_bits_;
+  bool has_neighbor_bits_;
+
+  // pairs of sensors within the maximum communication range of a range sweep
+  // in ascending order of distance, of which the first next_pair_ have
+  // channels.
+  std::vector<SensorPair> pairs_;
+  int next_pair_;
+
+  // connected components of the sensors with the current channels.
+  DisjointSets components_;
+
+  // parent candidates for the current channels, valid if
+  // has_parent_candidates_, which fails in the middle of a deployment and
+  // while the sensors are not connected.
+  ParentCandidates parent_candidates_;
+  bool has_parent_candidates_;
+
+  // spatial index of all sensors, with cells as large as the communication
+  // range.
+  SensorGrid grid_;
+
+  // row-major distance matrix for all sensors. It is only kept for small
+  // networks, where it fits in cache and saves recomputing the distances.
+  std::vector<Scalar> distances_;
 
   double communication_range_;
 };
 
-double CalculateMinimumCommunicationRange(const std::vector<Position>& positions);
+// Memory of CalculateMinimumCommunicationRange(), CanBeConnected() and the
+// placements checked with them, which may be kept across calls so that they
+// reuse it.
+struct MinimumRangeWorkspace {
+  SensorGrid grid;
+  DisjointSets components;
+  std::vector<SensorPair> pairs;
+  // sensors to be placed again by a repair of a placement.
+  std::vector<int> sensors;
+};
+
+// Returns the smallest communication range which connects all sensors. Uses
+// the given workspace if not NULL.
+double CalculateMinimumCommunicationRange(
+    const std::vector<Position>& positions,
+    MinimumRangeWorkspace* workspace = NULL);
+
+// Returns whether the given communication range connects all sensors, which
+// is the same as whether it is at least the minimum communication range, but
+// much cheaper. The sensors within range of each other are merged into the
+// components of the workspace, which stops as soon as all sensors are
+// connected, so the components are complete if they are not. Uses the given
+// workspace if not NULL.
+bool CanBeConnected(const std::vector<Position>& positions,
+                    double communication_range,
+                    MinimumRangeWorkspace* workspace = NULL);
 
 #endif  // NETWORKING_SENSOR_NETWORK_H_
@@ -15,23 +15,55 @@
 #include <queue>
 #include <set>
 
+#include "disjoint-sets.h"
 #include "sensor-network.h"
+#include "trace.h"
 #include "utils.h"
 
-void RandomizedSensorPlacer::GeneratePositions(std::vector<Position>* positions) {
+void RandomizedSensorPlacer::GeneratePositions(
+    Random* random, std::vector<Position>* positions) const {
   assert(positions != NULL);
   positions->clear();
 
   // Put the base station at the origin.
   positions->push_back(Position(0.0, 0.0));
 
-  for (int i = 1; i < num_sensors_; i++) {
-    positions->push_back(Position(DoubleRand(region_.min_x, region_.max_x),
-                                  DoubleRand(region_.min_y, region_.max_y)));
+  // Draw the coordinates a block of sensors at a time, x and y of each sensor
+  // next to each other, so that they take no memory from the heap.
+  const int kBlockSize = 256;
+  double uniforms[2 * kBlockSize];
+  const double width = region_.max_x - region_.min_x;
+  const double height = region_.max_y - region_.min_y;
+  for (int first = 1; first < num_sensors_; first += kBlockSize) {
+    const int count = std::min(kBlockSize, num_sensors_ - first);
+    random->FillDoubles(2 * count, uniforms);
+    for (int i = 0; i < count; i++) {
+      positions->push_back(
+          Position(region_.min_x + uniforms[2 * i] * width,
+                   region_.min_y + uniforms[2 * i + 1] * height));
+    }
   }
 }
 
-void RegularSensorPlacer::GeneratePositions(std::vector<Position>* positions) {
+bool RandomizedSensorPlacer::ResamplePositions(
+    const std::vector<int>& sensors,
+    Random* random,
+    std::vector<Position>* positions) const {
+  assert(positions != NULL);
+  const double width = region_.max_x - region_.min_x;
+  const double height = region_.max_y - region_.min_y;
+  for (int i = 0; i < sensors.size(); i++) {
+    assert(sensors[i] > 0);
+    double uniforms[2];
+    random->FillDoubles(2, uniforms);
+    (*positions)[sensors[i]] = Position(region_.min_x + uniforms[0] * width,
+                                        region_.min_y + uniforms[1] * height);
+  }
+  return true;
+}
+
+void RegularSensorPlacer::GeneratePositions(
+    Random* random, std::vector<Position>* positions) const {
   assert(positions != NULL);
   positions->clear();
 
@@ -46,18 +78,124 @@ void RegularSensorPlacer::GeneratePositions(std::vector<Position>* positions) {
   }
 }
 
-void GeneratePositionsThatCanBeConnected(double communication_range,
-                                         SensorPlacer* placer,
-                                         std::vector<Position>* positions) {
-  double min_communication_range;
-  int retries = 10;
-  while (retries-- > 0) {
-    placer->GeneratePositions(positions);
-    if (communication_range >= CalculateMinimumCommunicationRange(*positions)) {
-      return;
+namespace {
+
+// Checks placements with CanBeConnected().
+class PlacementChecker {
+ public:
+  PlacementChecker(double communication_range,
+                   MinimumRangeWorkspace* workspace)
+      : communication_range_(communication_range), workspace_(workspace) {}
+
+  bool IsConnected(const std::vector<Position>& positions) {
+    return CanBeConnected(positions, communication_range_, workspace_);
+  }
+
+  void FindDisconnectedSensors(std::vector<int>* sensors) {
+    workspace_->components.FindElementsOutsideSet(0, sensors);
+  }
+
+ private:
+  const double communication_range_;
+  MinimumRangeWorkspace* workspace_;
+};
+
+// Checks placements by deploying them into a network.
+class DeploymentChecker {
+ public:
+  DeploymentChecker(double communication_range, SensorNetwork* network)
+      : communication_range_(communication_range), network_(network) {}
+
+  bool IsConnected(const std::vector<Position>& positions) {
+    return network_->DeploySensors(positions, communication_range_);
+  }
+
+  void FindDisconnectedSensors(std::vector<int>* sensors) {
+    network_->FindDisconnectedSensors(sensors);
+  }
+
+ private:
+  const double communication_range_;
+  SensorNetwork* network_;
+};
+
+// Generates placements until the checker finds one connected. With
+// kRepairPlacement, the sensors of a placement which are not connected to the
+// base station are placed again, into the sensors of the workspace.
+template <typename Checker>
+void GenerateConnectedPositions(const SensorPlacer& placer,
+                                Random* random,
+                                std::vector<Position>* positions,
+                                MinimumRangeWorkspace* workspace,
+                                PlacementMode mode,
+                                Checker* checker) {
+  ScopedTimer timer("placement", "connected-placement");
+  const int kMaxAttempts = 10;
+  // A repair only moves the sensors not connected to the base station, which
+  // become fewer with every repair, so a placement may be repaired many times
+  // before it is given up.
+  const int kMaxRepairs = 100;
+  std::vector<int>& sensors = workspace->sensors;
+  for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+    {
+      ScopedTimer timer("placement", "generate-positions");
+      placer.GeneratePositions(random, positions);
+    }
+    for (int repair = 0; ; repair++) {
+      if (checker->IsConnected(*positions)) {
+        TraceCounter("placement-retries", attempt);
+        if (mode == kRepairPlacement) {
+          TraceCounter("placement-repairs", repair);
+        }
+        return;
+      }
+      if (mode != kRepairPlacement || repair == kMaxRepairs) {
+        break;
+      }
+      checker->FindDisconnectedSensors(&sensors);
+      TraceCounter("placement-repaired-sensors", sensors.size());
+      if (!placer.ResamplePositions(sensors, random, positions)) {
+        break;
+      }
     }
   }
   fprintf(stderr, "Failed to generate sensors with given communication range!\n");
   exit(1);
 }
 
+}  // namespace
+
+void GeneratePositionsThatCanBeConnected(double communication_range,
+                                         const SensorPlacer& placer,
+                                         Random* random,
+                                         std::vector<Position>* positions,
+                                         MinimumRangeWorkspace* workspace,
+                                         PlacementMode mode) {
+  if (workspace == NULL) {
+    MinimumRangeWorkspace local_workspace;
+    GeneratePositionsThatCanBeConnected(communication_range, placer, random,
+                                        positions, &local_workspace, mode);
+    return;
+  }
+  PlacementChecker checker(communication_range, workspace);
+  GenerateConnectedPositions(placer, random, positions, workspace, mode,
+                             &checker);
+}
+
+void DeploySensorsThatAreConnected(double communication_range,
+                                   const SensorPlacer& placer,
+                                   Random* random,
+                                   std::vector<Position>* positions,
+                                   SensorNetwork* network,
+                                   MinimumRangeWorkspace* workspace,
+                                   PlacementMode mode) {
+  if (workspace == NULL) {
+    MinimumRangeWorkspace local_workspace;
+    DeploySensorsThatAreConnected(communication_range, placer, random,
+                                  positions, network, &local_workspace, mode);
+    return;
+  }
+  DeploymentChecker checker(communication_range, network);
+  GenerateConnectedPositions(placer, random, positions, workspace, mode,
+                             &checker);
+}
@@ -6,17 +6,32 @@
 #define NETWORKING_SENSOR_PLACERS_H_
 
 #include <cassert>
+#include <cstddef>
 #include <map>
 #include <set>
 #include <vector>
 
 #include "position.h"
+#include "random.h"
 #include "region.h"
 
+class SensorNetwork;
+struct MinimumRangeWorkspace;
+
 class SensorPlacer {
  public:
   virtual ~SensorPlacer() {}
-  virtual void GeneratePositions(std::vector<Position>* positions) = 0;
+  virtual void GeneratePositions(Random* random,
+                                 std::vector<Position>* positions) const = 0;
+
+  // Draws new positions for the given sensors of a placement generated by
+  // this placer, leaving the other sensors in place. Returns false if the
+  // placer cannot move single sensors.
+  virtual bool ResamplePositions(const std::vector<int>& sensors,
+                                 Random* random,
+                                 std::vector<Position>* positions) const {
+    return false;
+  }
 };
 
 class RandomizedSensorPlacer : public SensorPlacer {
@@ -26,7 +41,13 @@ class RandomizedSensorPlacer : public SensorPlacer {
     assert(num_sensors > 0);
   }
 
-  void GeneratePositions(std::vector<Position>* positions);
+  void GeneratePositions(Random* random,
+                         std::vector<Position>* positions) const;
+
+  // The base station must not be resampled.
+  bool ResamplePositions(const std::vector<int>& sensors,
+                         Random* random,
+                         std::vector<Position>* positions) const;
 
  private:
   const int num_sensors_;
@@ -41,7 +62,8 @@ class RegularSensorPlacer : public SensorPlacer {
     assert(num_rows > 0);
   }
 
-  void GeneratePositions(std::vector<Position>* positions);
+  void GeneratePositions(Random* random,
+                         std::vector<Position>* positions) const;
 
  private:
   const int num_cols_;
@@ -49,8 +71,43 @@ class RegularSensorPlacer : public SensorPlacer {
   const Region region_;
 };
 
-void GeneratePositionsThatCanBeConnected(double communication_range,
-                                         SensorPlacer* placer,
-                                         std::vector<Position>* positions);
+// How GeneratePositionsThatCanBeConnected() deals with placements which are
+// not connected.
+enum PlacementMode {
+  // Throws the whole placement away and generates a new one, so that the
+  // placements are uniformly distributed among the connected ones.
+  kRegeneratePlacement,
+  // Keeps the sensors connected to the base station, and draws new positions
+  // only for the others, until all sensors are connected. Every repair can
+  // only grow the component of the base station, so this succeeds at much
+  // lower communication ranges, and much faster, but favors placements which
+  // connect easily. Falls back to regenerating if the placer cannot move
+  // single sensors.
+  kRepairPlacement,
+};
+
+// Replaces positions with a placement which is connected with the given
+// communication range, retrying a few times, and exits if there is none.
+// Checking the placements uses the given workspace if not NULL.
+void GeneratePositionsThatCanBeConnected(
+    double communication_range,
+    const SensorPlacer& placer,
+    Random* random,
+    std::vector<Position>* positions,
+    MinimumRangeWorkspace* workspace = NULL,
+    PlacementMode mode = kRegeneratePlacement);
+
+// Same as GeneratePositionsThatCanBeConnected() followed by
+// network->DeploySensors(*positions, communication_range), but every
+// placement is checked by deploying it, whose channels tell whether it is
+// connected, instead of checking it separately first.
+void DeploySensorsThatAreConnected(
+    double communication_range,
+    const SensorPlacer& placer,
+    Random* random,
+    std::vector<Position>* positions,
+    SensorNetwork* network,
+    MinimumRangeWorkspace* workspace = NULL,
+    PlacementMode mode = kRegeneratePlacement);
 
 #endif  // NETWORKING_SENSOR_PLACERS_H_
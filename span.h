@@ -0,0 +1,57 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_SPAN_H_
+#define NETWORKING_SPAN_H_
+
+#include <cassert>
+#include <cstddef>
+
+// Read-only view of a contiguous range of elements owned by someone else.
+template <typename T>
+class Span {
+ public:
+  typedef const T* const_iterator;
+
+  Span() : begin_(NULL), end_(NULL) {}
+
+  Span(const T* begin, const T* end) : begin_(begin), end_(end) {}
+
+  const T* begin() const {
+    return begin_;
+  }
+
+  const T* end() const {
+    return end_;
+  }
+
+  int size() const {
+    return end_ - begin_;
+  }
+
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+  const T& operator[](int i) const {
+    assert(i >= 0 && i < size());
+    return begin_[i];
+  }
+
+  const T& front() const {
+    assert(!empty());
+    return *begin_;
+  }
+
+  const T& back() const {
+    assert(!empty());
+    return *(end_ - 1);
+  }
+
+ private:
+  const T* begin_;
+  const T* end_;
+};
+
+#endif  // NETWORKING_SPAN_H_
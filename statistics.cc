@@ -0,0 +1,84 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "statistics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Samples below this are counted as 0, which keeps the bucket indices small.
+const double kMinBucketedSample = 1e-12;
+
+}  // namespace
+
+MetricStatistics::MetricStatistics(double relative_accuracy)
+    : gamma_((1.0 + relative_accuracy) / (1.0 - relative_accuracy)),
+      log_gamma_(std::log(gamma_)),
+      count_(0),
+      mean_(0.0),
+      m2_(0.0),
+      min_(0.0),
+      max_(0.0),
+      num_zeros_(0) {
+  assert(relative_accuracy > 0.0 && relative_accuracy < 1.0);
+}
+
+int MetricStatistics::GetBucket(double sample) const {
+  return int(std::ceil(std::log(sample) / log_gamma_));
+}
+
+void MetricStatistics::Add(double sample) {
+  assert(sample >= 0.0);
+  if (count_ == 0) {
+    min_ = max_ = sample;
+  } else {
+    min_ = std::min(min_, sample);
+    max_ = std::max(max_, sample);
+  }
+  count_++;
+  double delta = sample - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (sample - mean_);
+
+  if (sample < kMinBucketedSample) {
+    num_zeros_++;
+  } else {
+    buckets_[GetBucket(sample)]++;
+  }
+}
+
+double MetricStatistics::variance() const {
+  return count_ > 1 ? m2_ / (count_ - 1) : 0.0;
+}
+
+double MetricStatistics::stddev() const {
+  return std::sqrt(variance());
+}
+
+double MetricStatistics::Quantile(double fraction) const {
+  assert(fraction >= 0.0 && fraction <= 1.0);
+  if (count_ == 0) {
+    return 0.0;
+  }
+
+  // Zero-based rank of the sample to look up.
+  const int64_t rank = int64_t(fraction * (count_ - 1));
+  int64_t seen = num_zeros_;
+  if (rank < seen) {
+    return min_;
+  }
+  for (std::map<int, int64_t>::const_iterator it = buckets_.begin();
+       it != buckets_.end(); ++it) {
+    seen += it->second;
+    if (rank < seen) {
+      // The point of the bucket with the least relative error to both ends.
+      double value = 2.0 * std::exp(it->first * log_gamma_) / (gamma_ + 1.0);
+      return std::min(std::max(value, min_), max_);
+    }
+  }
+  return max_;
+}
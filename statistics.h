@@ -0,0 +1,71 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_STATISTICS_H_
+#define NETWORKING_STATISTICS_H_
+
+#include <stdint.h>
+
+#include <map>
+
+// Streaming summary of a sequence of non-negative samples, without keeping
+// the samples themselves.
+//
+// The mean and variance are updated with Welford's method, so they do not
+// lose precision to large sums. Quantiles come from a sketch of
+// logarithmically sized buckets: every sample falls into the bucket
+// (gamma^(i-1), gamma^i] with gamma = (1 + accuracy) / (1 - accuracy), and a
+// quantile is answered within the relative accuracy of the true sample.
+class MetricStatistics {
+ public:
+  explicit MetricStatistics(double relative_accuracy = 0.01);
+
+  void Add(double sample);
+
+  int64_t count() const {
+    return count_;
+  }
+
+  // All of the following return 0 without samples.
+  double mean() const {
+    return mean_;
+  }
+
+  // Returns the sample variance, with Bessel's correction.
+  double variance() const;
+
+  double stddev() const;
+
+  double min() const {
+    return count_ > 0 ? min_ : 0.0;
+  }
+
+  double max() const {
+    return count_ > 0 ? max_ : 0.0;
+  }
+
+  // Returns the approximate value at the given fraction in [0, 1] of the
+  // sorted samples.
+  double Quantile(double fraction) const;
+
+ private:
+  int GetBucket(double sample) const;
+
+  double gamma_;
+  double log_gamma_;
+
+  int64_t count_;
+  double mean_;
+  // Sum of the squared differences from the mean.
+  double m2_;
+  double min_;
+  double max_;
+
+  // Number of samples too close to 0 for the log buckets.
+  int64_t num_zeros_;
+  // bucket index -> number of samples in the bucket
+  std::map<int, int64_t> buckets_;
+};
+
+#endif  // NETWORKING_STATISTICS_H_
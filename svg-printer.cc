@@ -10,16 +10,22 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <ctime>
-#include <iterator>
-#include <map>
-#include <queue>
-#include <set>
 
 #include "position.h"
 #include "region.h"
 #include "sensor-network.h"
 
+namespace {
+
+// Number of segments or sensors per <path> element. Renderers cope better
+// with a few long paths than with a single huge one.
+const int kMaxItemsPerPath = 4096;
+
+// The buffered output is written to the file in blocks of about this size.
+const size_t kFlushSize = 1 << 16;
+
+}  // namespace
+
 class PositionConverter {
  public:
   PositionConverter(double scale, const Position& origin)
@@ -46,22 +52,82 @@ class PositionConverter {
 SvgPrinter::SvgPrinter(const std::string& filename,
                        const std::string& title,
                        const Region& region,
-                       double scale)
-    : filename_(filename), title_(title), region_(region), scale_(scale) {
+                       double scale,
+                       const SvgDetail& detail)
+    : filename_(filename),
+      title_(title),
+      region_(region),
+      scale_(scale),
+      detail_(detail) {
+  assert(detail_.channel_stride > 0);
   file_ = std::fopen(filename_.c_str(), "w");
   if (!file_) {
     fprintf(stderr, "Failed to open file %s!\n", filename_.c_str());
     exit(1);
   }
+  buffer_.reserve(kFlushSize * 2);
 }
 
 SvgPrinter::~SvgPrinter() {
+  Flush();
   std::fclose(file_);
 }
 
-void SvgPrinter::PrintNetwork(const SensorNetwork& network,
-                              bool print_channels,
-                              bool print_routings) {
+void SvgPrinter::Flush() {
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  buffer_.clear();
+}
+
+void SvgPrinter::Write(const char* s) {
+  buffer_ += s;
+  if (buffer_.size() >= kFlushSize) {
+    Flush();
+  }
+}
+
+void SvgPrinter::WriteNumber(double x) {
+  long long tenths = std::llround(x * 10.0);
+  char digits[24];
+  char* p = digits + sizeof(digits);
+  *--p = '\0';
+  bool negative = tenths < 0;
+  if (negative) {
+    tenths = -tenths;
+  }
+  if (tenths % 10 != 0) {
+    *--p = '0' + tenths % 10;
+    *--p = '.';
+  }
+  long long whole = tenths / 10;
+  do {
+    *--p = '0' + whole % 10;
+    whole /= 10;
+  } while (whole > 0);
+  if (negative) {
+    *--p = '-';
+  }
+  Write(p);
+}
+
+void SvgPrinter::WritePoint(const Position& p) {
+  WriteNumber(p.x);
+  Write(" ");
+  WriteNumber(p.y);
+}
+
+void SvgPrinter::BeginPath(const char* attributes) {
+  Write("<path ");
+  Write(attributes);
+  Write(" d='");
+}
+
+void SvgPrinter::EndPath() {
+  Write("' />\n");
+}
+
+void SvgPrinter::Print(const SensorNetwork& network,
+                       bool print_channels,
+                       const RoutingTree* tree) {
   const static int RADIUS = 8;
   const static int STROKE_WIDTH = 1;
   const static int FONT_HEIGHT = 20;
@@ -72,72 +138,148 @@ void SvgPrinter::PrintNetwork(const SensorNetwork& network,
               (RADIUS + STROKE_WIDTH) * 2);
   int h = int((region_.max_y - region_.min_y) * scale_ +
               (RADIUS + STROKE_WIDTH) * 2);
-  fprintf(file_,
-          "<svg width='%d' height='%d'"
-          " xmlns='http://www.w3.org/2000/svg'"
-          " xmlns:xlink='http://www.w3.org/1999/xlink'>\n"
-          "<rect x='0' y='0' width='%d' height='%d'"
-          " style='fill:white;stroke:black;stroke-width:1;' />\n",
-          w, h + FONT_HEIGHT * 2, w, h);
-
-  for (int i = 0; i < network.num_sensors(); i++) {
-    const Position& p = network.GetPosition(i);
-    if (print_channels) {
-      const std::set<int>& neighbors = network.GetNeighbors(i);
-      for (std::set<int>::const_iterator neighbor = neighbors.begin();
+  char header[512];
+  snprintf(header, sizeof(header),
+           "<svg width='%d' height='%d'"
+           " xmlns='http://www.w3.org/2000/svg'"
+           " xmlns:xlink='http://www.w3.org/1999/xlink'>\n"
+           "<rect x='0' y='0' width='%d' height='%d'"
+           " style='fill:white;stroke:black;stroke-width:1;' />\n",
+           w, h + FONT_HEIGHT * 2, w, h);
+  Write(header);
+
+  if (print_channels) {
+    const char* style = "stroke='gray' stroke-width='1'"
+                        " stroke-dasharray='1,1' fill='none'";
+    int num_channels = 0;
+    int num_printed = 0;
+    for (int i = 0; i < network.num_sensors(); i++) {
+      Span<int> neighbors = network.GetNeighbors(i);
+      for (const int* neighbor = neighbors.begin();
            neighbor != neighbors.end();
            ++neighbor) {
-        if (i < *neighbor) {
-          const Position& q = network.GetPosition(*neighbor);
-          fprintf(file_,
-                  "<path d='M %f %f L %f %f' stroke='gray' stroke-width='1'"
-                   " stroke-dasharray='1,1' />\n",
-                   c.ConvertX(p.x), c.ConvertY(p.y),
-                   c.ConvertX(q.x), c.ConvertY(q.y));
+        if (i >= *neighbor ||
+            num_channels++ % detail_.channel_stride != 0) {
+          continue;
         }
+        if (num_printed % kMaxItemsPerPath == 0) {
+          if (num_printed > 0) {
+            EndPath();
+          }
+          BeginPath(style);
+        }
+        num_printed++;
+        Write("M");
+        WritePoint(c.Convert(network.GetPosition(i)));
+        Write("L");
+        WritePoint(c.Convert(network.GetPosition(*neighbor)));
       }
     }
-    if (print_routings) {
-      int parent = network.GetParent(i);
-      if (parent != -1) {
-        const Position& q = network.GetPosition(parent);
-        fprintf(file_,
-                "<line x1='%f' y1='%f' x2='%f' y2='%f' "
-                " style='stroke:royalblue;stroke-width:2' />\n",
-                c.ConvertX(p.x), c.ConvertY(p.y),
-                c.ConvertX(q.x), c.ConvertY(q.y));
+    if (num_printed > 0) {
+      EndPath();
+    }
+  }
+
+  if (tree != NULL) {
+    const char* style = "stroke='royalblue' stroke-width='2' fill='none'";
+    int num_printed = 0;
+    for (int i = 0; i < network.num_sensors(); i++) {
+      int parent = tree->GetParent(i);
+      if (parent == -1) {
+        continue;
       }
+      if (num_printed % kMaxItemsPerPath == 0) {
+        if (num_printed > 0) {
+          EndPath();
+        }
+        BeginPath(style);
+      }
+      num_printed++;
+      Write("M");
+      WritePoint(c.Convert(network.GetPosition(i)));
+      Write("L");
+      WritePoint(c.Convert(network.GetPosition(parent)));
+    }
+    if (num_printed > 0) {
+      EndPath();
     }
   }
 
   if (network.num_sensors() > 0) {
-    fprintf(file_,
-            "<circle cx='%f' cy='%f' r='%d' stroke='yellow' stroke-width='%d'"
-            " fill='red' />\n",
-            c.ConvertX(network.GetPosition(0).x),
-            c.ConvertY(network.GetPosition(0).y),
-            RADIUS, STROKE_WIDTH);
+    char circle[256];
+    snprintf(circle, sizeof(circle),
+             "<circle cx='%.1f' cy='%.1f' r='%d' stroke='yellow'"
+             " stroke-width='%d' fill='red' />\n",
+             c.ConvertX(network.GetPosition(0).x),
+             c.ConvertY(network.GetPosition(0).y),
+             RADIUS, STROKE_WIDTH);
+    Write(circle);
   }
-  for (int i = 1; i < network.num_sensors(); i++) {
-    const Position& p = network.GetPosition(i);
-    fprintf(file_,
-            "<circle cx='%f' cy='%f' r='%d' stroke='green' stroke-width='%d'"
-            " fill='yellow' />\n",
-            c.ConvertX(p.x), c.ConvertY(p.y), RADIUS, STROKE_WIDTH);
+
+  // Shrink the sensors so that they do not cover each other, with their
+  // outlines in proportion.
+  const double area =
+      (region_.max_x - region_.min_x) * (region_.max_y - region_.min_y);
+  const double spacing =
+      scale_ * std::sqrt(area / std::max(network.num_sensors(), 1));
+  const double radius = std::min(double(RADIUS), spacing / 2.0);
+  if (radius >= detail_.min_node_radius) {
+    char style[128];
+    snprintf(style, sizeof(style),
+             "stroke='green' stroke-width='%.2f' fill='yellow'",
+             STROKE_WIDTH * radius / RADIUS);
+    for (int i = 1; i < network.num_sensors(); i++) {
+      if ((i - 1) % kMaxItemsPerPath == 0) {
+        if (i > 1) {
+          EndPath();
+        }
+        BeginPath(style);
+      }
+      // A circle is drawn as two half arcs from its leftmost point.
+      const Position p = c.Convert(network.GetPosition(i));
+      Write("M");
+      WritePoint(Position(p.x - radius, p.y));
+      Write("a");
+      WriteNumber(radius);
+      Write(" ");
+      WriteNumber(radius);
+      Write(" 0 1 0 ");
+      WriteNumber(radius * 2.0);
+      Write(" 0a");
+      WriteNumber(radius);
+      Write(" ");
+      WriteNumber(radius);
+      Write(" 0 1 0 ");
+      WriteNumber(-radius * 2.0);
+      Write(" 0");
+    }
+    if (network.num_sensors() > 1) {
+      EndPath();
+    }
   }
 
-  fprintf(file_,
-          "<text x='%d' y='%d' fill='royalblue' text-anchor='middle' "
-          "alignment-baseline='middle' font-size='%dpx'>%s</text>\n",
-          w / 2, h + FONT_HEIGHT, FONT_HEIGHT, title_.c_str());
-  fprintf(file_, "</svg>\n");
+  char text[256];
+  snprintf(text, sizeof(text),
+           "<text x='%d' y='%d' fill='royalblue' text-anchor='middle' "
+           "alignment-baseline='middle' font-size='%dpx'>",
+           w / 2, h + FONT_HEIGHT, FONT_HEIGHT);
+  Write(text);
+  Write(title_.c_str());
+  Write("</text>\n");
+  Write("</svg>\n");
+  Flush();
 }
 
-void SvgPrinter::PrintChannels(const SensorNetwork& network) {
-  PrintNetwork(network, true, false);
+void SvgPrinter::PrintNetwork(const SensorNetwork& network,
+                              const RoutingTree& tree) {
+  Print(network, true, &tree);
 }
 
-void SvgPrinter::PrintRoutings(const SensorNetwork& network) {
-  PrintNetwork(network, false, true);
+void SvgPrinter::PrintChannels(const SensorNetwork& network) {
+  Print(network, true, NULL);
 }
 
+void SvgPrinter::PrintRoutings(const SensorNetwork& network,
+                               const RoutingTree& tree) {
+  Print(network, false, &tree);
+}
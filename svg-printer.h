@@ -9,32 +9,75 @@
 #include <string>
 
 #include "region.h"
+#include "routing-tree.h"
 #include "sensor-network.h"
 
+// Level of detail of the printed networks, so that very large networks still
+// make images which can be opened.
+struct SvgDetail {
+  SvgDetail() : channel_stride(1), min_node_radius(1.0) {}
+
+  // Only every channel_stride-th channel is printed.
+  int channel_stride;
+
+  // Sensors are shrunk to fit the average spacing of the sensors in the
+  // image, and hidden once their radius in pixels falls below this. The base
+  // station is always printed.
+  double min_node_radius;
+};
+
+// Prints sensor networks as SVG images.
+//
+// The output is buffered and flushed in large blocks, and every layer, i.e.
+// the channels, the routes and the sensors, is merged into a few <path>
+// elements with coordinates rounded to a tenth of a pixel, which keeps the
+// images of large networks compact.
 class SvgPrinter {
  public:
   SvgPrinter(const std::string& filename,
              const std::string& title,
              const Region& region,
-             double scale = 1.0);
+             double scale = 1.0,
+             const SvgDetail& detail = SvgDetail());
 
   ~SvgPrinter();
 
-  void PrintNetwork(const SensorNetwork& network,
-                    bool print_channels = true,
-                    bool print_routings = true);
+  // Prints the channels of the network and the routes of the tree.
+  void PrintNetwork(const SensorNetwork& network, const RoutingTree& tree);
 
   void PrintChannels(const SensorNetwork& network);
 
-  void PrintRoutings(const SensorNetwork& network);
+  void PrintRoutings(const SensorNetwork& network, const RoutingTree& tree);
 
  private:
+  // Prints the routes of the tree unless it is NULL.
+  void Print(const SensorNetwork& network,
+             bool print_channels,
+             const RoutingTree* tree);
+
+  void Write(const char* s);
+
+  // Writes the number with at most one decimal.
+  void WriteNumber(double x);
+
+  void WritePoint(const Position& p);
+
+  // Starts a <path> element with the given attributes, to which the
+  // following points are written as its path data.
+  void BeginPath(const char* attributes);
+
+  void EndPath();
+
+  void Flush();
+
   const std::string filename_;
   const std::string title_;
   const Region region_;
   const double scale_;
+  const SvgDetail detail_;
 
   FILE* file_;
+  std::string buffer_;
 };
 
 #endif  // NETWORKING_SVG_PRINTER_H_
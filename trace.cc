@@ -0,0 +1,189 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceRecord {
+  const char* category;  // NULL for counters.
+  const char* name;
+  int64_t timestamp;
+  // The duration of a span, or the value of a counter.
+  int64_t value;
+};
+
+struct ThreadRecords {
+  int thread_id;
+  std::vector<TraceRecord> records;
+};
+
+std::chrono::steady_clock::time_point start_time;
+FILE* trace_file = NULL;
+std::string trace_filename;
+
+// The records of every thread that recorded, in the order of their first
+// records. The threads only take the lock once, for registering their buffer,
+// which lives until the process exits.
+std::mutex threads_mutex;
+std::vector<ThreadRecords*> threads;
+
+ThreadRecords* GetThreadRecords() {
+  thread_local ThreadRecords* records = NULL;
+  if (records == NULL) {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    records = new ThreadRecords();
+    records->thread_id = threads.size();
+    threads.push_back(records);
+  }
+  return records;
+}
+
+struct Summary {
+  Summary() : count(0), total(0), max(0) {}
+
+  void Add(int64_t value) {
+    count++;
+    total += value;
+    max = std::max(max, value);
+  }
+
+  int64_t count;
+  int64_t total;
+  int64_t max;
+};
+
+bool CompareTotals(const std::pair<std::string, Summary>& a,
+                   const std::pair<std::string, Summary>& b) {
+  return a.second.total > b.second.total;
+}
+
+void WriteTraceFile() {
+  fprintf(trace_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  for (int t = 0; t < threads.size(); t++) {
+    const ThreadRecords& thread = *threads[t];
+    fprintf(trace_file,
+            "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+            "\"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+            first ? "" : ",\n", thread.thread_id, thread.thread_id);
+    first = false;
+    for (int i = 0; i < thread.records.size(); i++) {
+      const TraceRecord& record = thread.records[i];
+      if (record.category != NULL) {
+        fprintf(trace_file,
+                ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+                "\"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                record.name, record.category, thread.thread_id,
+                record.timestamp / 1e3, record.value / 1e3);
+      } else {
+        fprintf(trace_file,
+                ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, "
+                "\"tid\": %d, \"ts\": %.3f, \"args\": {\"value\": %lld}}",
+                record.name, thread.thread_id, record.timestamp / 1e3,
+                (long long) record.value);
+      }
+    }
+  }
+  fprintf(trace_file, "\n]}\n");
+}
+
+// Prints the phases by their total time, longest first, and the counters by
+// name. The times of the threads add up, so the total time of a phase may
+// exceed the wall time of the run.
+void PrintSummary() {
+  std::map<std::string, Summary> spans;
+  std::map<std::string, Summary> counters;
+  for (int t = 0; t < threads.size(); t++) {
+    const std::vector<TraceRecord>& records = threads[t]->records;
+    for (int i = 0; i < records.size(); i++) {
+      if (records[i].category != NULL) {
+        spans[std::string(records[i].category) + "/" + records[i].name].Add(
+            records[i].value);
+      } else {
+        counters[records[i].name].Add(records[i].value);
+      }
+    }
+  }
+
+  std::vector<std::pair<std::string, Summary> > sorted(spans.begin(),
+                                                        spans.end());
+  std::stable_sort(sorted.begin(), sorted.end(), CompareTotals);
+
+  printf("\nTrace summary (%s):\n", trace_filename.c_str());
+  printf("%-40s %10s %12s %12s %12s\n", "phase", "count", "total ms",
+         "mean us", "max us");
+  for (int i = 0; i < sorted.size(); i++) {
+    const Summary& summary = sorted[i].second;
+    printf("%-40s %10lld %12.3f %12.3f %12.3f\n", sorted[i].first.c_str(),
+           (long long) summary.count, summary.total / 1e6,
+           summary.total / 1e3 / summary.count, summary.max / 1e3);
+  }
+
+  if (!counters.empty()) {
+    printf("\n%-40s %10s %12s %12s %12s\n", "counter", "count", "total",
+           "mean", "max");
+    for (std::map<std::string, Summary>::const_iterator it = counters.begin();
+         it != counters.end(); ++it) {
+      const Summary& summary = it->second;
+      printf("%-40s %10lld %12lld %12.3f %12lld\n", it->first.c_str(),
+             (long long) summary.count, (long long) summary.total,
+             double(summary.total) / summary.count, (long long) summary.max);
+    }
+  }
+}
+
+}  // namespace
+
+namespace trace_internal {
+
+bool enabled = false;
+
+int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_time).count();
+}
+
+void AddSpan(const char* category, const char* name, int64_t begin,
+             int64_t end) {
+  TraceRecord record = {category, name, begin, end - begin};
+  GetThreadRecords()->records.push_back(record);
+}
+
+void AddCounter(const char* name, int64_t value) {
+  TraceRecord record = {NULL, name, Now(), value};
+  GetThreadRecords()->records.push_back(record);
+}
+
+}  // namespace trace_internal
+
+bool StartTracing(const std::string& filename) {
+  trace_file = fopen(filename.c_str(), "w");
+  if (trace_file == NULL) {
+    return false;
+  }
+  trace_filename = filename;
+  start_time = std::chrono::steady_clock::now();
+  trace_internal::enabled = true;
+  return true;
+}
+
+void FinishTracing() {
+  if (!trace_internal::enabled) {
+    return;
+  }
+  trace_internal::enabled = false;
+
+  WriteTraceFile();
+  fclose(trace_file);
+  trace_file = NULL;
+  PrintSummary();
+}
@@ -0,0 +1,83 @@
+// Wireless Sensor Network Routing Algorithms
+// ==========================================
+// Created By: Min Xu <xukmin@gmail.com>
+
+#ifndef NETWORKING_TRACE_H_
+#define NETWORKING_TRACE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+// Instrumentation of the phases of a simulation, to find out where a slow run
+// spends its time.
+//
+// Tracing is off by default, and then a ScopedTimer or TraceCounter() costs
+// no more than the test of a flag. Once tracing is started, every timer
+// records the span of time of its scope, and every counter a value, e.g. the
+// number of placement retries, into a buffer of the recording thread, so the
+// worker threads never wait for each other. FinishTracing() writes all records
+// as a Chrome trace-event JSON file, which chrome://tracing and Perfetto open,
+// and prints a summary table of the phases and counters.
+//
+// Only the pointers to the categories and names are recorded, so they must
+// outlive the tracing, e.g. string literals.
+
+// Starts tracing into the given file. Must be called at most once, before any
+// thread records, e.g. before the simulation starts. Returns false if the file
+// cannot be written.
+bool StartTracing(const std::string& filename);
+
+// Writes the trace file and prints the summary. Must be called after the
+// recording threads are done. Does nothing if tracing was not started.
+void FinishTracing();
+
+namespace trace_internal {
+
+extern bool enabled;
+
+// Returns the nanoseconds since tracing started.
+int64_t Now();
+
+void AddSpan(const char* category, const char* name, int64_t begin,
+             int64_t end);
+
+void AddCounter(const char* name, int64_t value);
+
+}  // namespace trace_internal
+
+inline bool IsTracing() {
+  return trace_internal::enabled;
+}
+
+// Records the time from its construction to its destruction as a span of the
+// given phase.
+class ScopedTimer {
+ public:
+  ScopedTimer(const char* category, const char* name)
+      : category_(category),
+        name_(name),
+        begin_(IsTracing() ? trace_internal::Now() : 0) {
+  }
+
+  ~ScopedTimer() {
+    if (IsTracing()) {
+      trace_internal::AddSpan(category_, name_, begin_, trace_internal::Now());
+    }
+  }
+
+ private:
+  const char* category_;
+  const char* name_;
+  int64_t begin_;
+};
+
+// Records a value of the given counter. The summary sums up all values of a
+// counter, and the trace shows them over time.
+inline void TraceCounter(const char* name, int64_t value) {
+  if (IsTracing()) {
+    trace_internal::AddCounter(name, value);
+  }
+}
+
+#endif  // NETWORKING_TRACE_H_
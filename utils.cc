@@ -4,12 +4,10 @@
 
 #include "utils.h"
 
-#include <cstdlib>
-#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
 
-double DoubleRand(double min, double max) {
-  return min + (((double) std::rand()) / RAND_MAX) * (max - min);
-}
+#include <sstream>
 
 std::string IntToString(int n) {
   std::ostringstream os;
@@ -17,3 +15,31 @@ std::string IntToString(int n) {
   return os.str();
 }
 
+bool GetOptionValue(const std::string& arg,
+                    const std::string& name,
+                    std::string* value) {
+  const std::string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+int64_t GetPhysicalMemory() {
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long page_size = sysconf(_SC_PAGE_SIZE);
+  if (pages <= 0 || page_size <= 0) {
+    return 0;
+  }
+  return int64_t(pages) * page_size;
+}
+
+int64_t GetPeakMemoryUsage() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // Linux reports kilobytes.
+  return int64_t(usage.ru_maxrss) * 1024;
+}
@@ -5,12 +5,24 @@
 #ifndef NETWORKING_UTILS_H_
 #define NETWORKING_UTILS_H_
 
-#include <string>
+#include <stdint.h>
 
-// Generates a double random number between min and max (inclusive).
-double DoubleRand(double min, double max);
+#include <string>
 
 std::string IntToString(int n);
 
+// Returns whether arg is a command line option of the form --<name>=<value>,
+// and stores the value if it is.
+bool GetOptionValue(const std::string& arg,
+                    const std::string& name,
+                    std::string* value);
+
+// Returns the size of the physical memory in bytes, or 0 if it is unknown.
+int64_t GetPhysicalMemory();
+
+// Returns the peak resident memory of the process so far in bytes, or 0 if it
+// is unknown.
+int64_t GetPeakMemoryUsage();
+
 #endif  // NETWORKING_UTILS_H_
 
@@ -0,0 +1,65 @@
+#!/bin/bash
+#
+# Wireless Sensor Network Routing Algorithms
+# ==========================================
+# Created By: Min Xu <xukmin@gmail.com>
+#
+# Run the double and the float build of the simulation on the same simulations
+# and report how far the metrics of the float build diverge, for every data
+# file: the number of values which differ, and the largest and mean absolute
+# and relative differences. The float build is made by
+#     make validate-precision
+# Usage:
+#     ./validate-precision.sh [<arguments of calculate-routing-metrics>]
+# The seed is 1 unless given. The outputs are kept in precision/.
+
+set -e
+
+rm -rf precision
+mkdir -p precision/double precision/float
+(cd precision/double &&
+    ../../calculate-routing-metrics --seed=1 "${@}" > output.txt)
+(cd precision/float &&
+    ../../float/calculate-routing-metrics --seed=1 "${@}" > output.txt)
+
+echo "$(grep '^scalar = ' precision/double/output.txt) vs." \
+     "$(grep '^scalar = ' precision/float/output.txt)"
+printf "%-48s %13s %11s %11s %11s %11s\n" "file" "differing" "max abs" \
+       "mean abs" "max rel" "mean rel"
+
+for expected in precision/double/metrics-*.dat precision/double/events-*.dat; do
+  file="$(basename "${expected}")"
+  case "${file}" in
+    *-heatmap.dat) continue ;;
+    events-*) keys=2 ;;  # communication and sensing range
+    *) keys=1 ;;  # communication range
+  esac
+  [[ -e "${expected}" ]] || continue
+
+  # Both files hold the same lines of the same columns, so the pasted line
+  # holds the expected values in its first half and the actual in the second.
+  paste -d ' ' "${expected}" "precision/float/${file}" | awk \
+      -v file="${file}" -v keys="${keys}" '
+    {
+      half = NF / 2
+      for (i = keys + 1; i <= half; i++) {
+        expected = $i
+        actual = $(i + half)
+        diff = actual - expected
+        if (diff < 0) diff = -diff
+        scale = expected < 0 ? -expected : expected
+        rel = scale > 0 ? diff / scale : (diff > 0 ? 1 : 0)
+        count++
+        if (diff > 0) differing++
+        sum_abs += diff
+        sum_rel += rel
+        if (diff > max_abs) max_abs = diff
+        if (rel > max_rel) max_rel = rel
+      }
+    }
+    END {
+      if (count == 0) count = 1
+      printf "%-48s %6d/%-6d %11.3g %11.3g %11.3g %11.3g\n", file, differing,
+             count, max_abs, sum_abs / count, max_rel, sum_rel / count
+    }'
+done